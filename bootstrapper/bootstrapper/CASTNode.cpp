@@ -17,6 +17,7 @@
 #include "CExpressionBaseASTNode.h"
 #include "CStringHelper.h"
 #include "CDataType.h"
+#include "CArena.h"
 
 #include "CAliasASTNode.h"
 #include "CDeclarationASTNode.h"
@@ -62,16 +63,38 @@ CASTNode::CASTNode(CASTNode* parent, CToken token)
 // =================================================================
 CASTNode::~CASTNode()
 {
-	for (unsigned int i = 0; i < Children.size(); i++)
-	{
-		CASTNode* node = Children.at(i);
-		delete node;
-	}
-
+	// Children are not deleted here, nodes can be referenced from more
+	// than one place once cloned or moved between packages. The arena
+	// they were allocated from owns them and destroys them all at once.
 	Parent = NULL;
 	Children.clear();
 }
 
+// =================================================================
+//	Allocates memory for a new node from the current arena.
+// =================================================================
+void* CASTNode::operator new(size_t size)
+{
+	return CArena::AllocateObject(size, &CASTNode::Destroy);
+}
+
+// =================================================================
+//	Frees the memory used by a node, nodes allocated from an arena
+//	are released with it.
+// =================================================================
+void CASTNode::operator delete(void* ptr)
+{
+	CArena::FreeObject(ptr);
+}
+
+// =================================================================
+//	Destroys a node that is still alive when its arena is released.
+// =================================================================
+void CASTNode::Destroy(void* ptr)
+{
+	static_cast<CASTNode*>(ptr)->~CASTNode();
+}
+
 // =================================================================
 //	Converts this node to a string representation.
 // =================================================================
@@ -210,7 +233,16 @@ void CASTNode::SemantChildren(CSemanter* semanter)
 {
 	for (std::vector<CASTNode*>::iterator iter = Children.begin(); iter != Children.end(); iter++)
 	{
-		(*iter)->Semant(semanter);
+		CASTNode* node	 = *iter;
+		CASTNode* result = node->Semant(semanter);
+
+		// Statements can replace themselves, eg. an if statement with a 
+		// constant condition is replaced by the branch it takes.
+		if (result != NULL && result != node)
+		{
+			*iter = result;
+			result->Parent = this;
+		}
 	}
 }
 
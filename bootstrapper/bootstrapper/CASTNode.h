@@ -112,7 +112,12 @@ public:
 	// Constructing.
 	CASTNode();
 	CASTNode(CASTNode* parent, CToken token);
-	~CASTNode();
+	virtual ~CASTNode();
+
+	// Nodes are allocated from, and owned by, the current compiles arena.
+	static void* operator new		(size_t size);
+	static void  operator delete	(void* ptr);
+	static void  Destroy			(void* ptr);
 
 };
 
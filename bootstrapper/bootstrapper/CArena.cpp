@@ -0,0 +1,242 @@
+/* *****************************************************************
+
+		CArena.cpp
+
+		Copyright (C) 2012 Tim Leonard - All Rights Reserved
+
+   ***************************************************************** */
+
+#include "CArena.h"
+
+#include <stdlib.h>
+#include <new>
+
+CArena*				CArena::g_current_arena = NULL;
+std::vector<char*>	CArena::g_free_chunks;
+
+// =================================================================
+//	Constructs a new instance of this class.
+// =================================================================
+CArena::CArena()
+{
+	m_chunk_position	= NULL;
+	m_chunk_end			= NULL;
+	m_allocation_count	= 0;
+	m_allocated_bytes	= 0;
+}
+
+// =================================================================
+//	Disposes of this arena and everything allocated from it.
+// =================================================================
+CArena::~CArena()
+{
+	Release();
+}
+
+// =================================================================
+//	Releases everything allocated from this arena. Objects that
+//	have not been deleted are destroyed newest first, then chunks 
+//	are returned to the free list to be used by the next arena.
+// =================================================================
+void CArena::Release()
+{
+	if (g_current_arena == this)
+	{
+		g_current_arena = NULL;
+	}
+
+	for (std::vector<char*>::reverse_iterator iter = m_objects.rbegin(); iter != m_objects.rend(); iter++)
+	{
+		CArenaObjectHeader* header = (CArenaObjectHeader*)(*iter);
+		CArenaDestructor destructor = header->Destructor;
+		if (destructor != NULL)
+		{
+			header->Destructor = NULL;
+			destructor((*iter) + ARENA_ALIGNMENT);
+		}
+	}
+	m_objects.clear();
+
+	for (std::vector<char*>::iterator iter = m_chunks.begin(); iter != m_chunks.end(); iter++)
+	{
+		g_free_chunks.push_back(*iter);
+	}
+	m_chunks.clear();
+
+	for (std::vector<char*>::iterator iter = m_large_allocations.begin(); iter != m_large_allocations.end(); iter++)
+	{
+		free(*iter);
+	}
+	m_large_allocations.clear();
+
+	m_chunk_position	= NULL;
+	m_chunk_end			= NULL;
+	m_allocation_count	= 0;
+	m_allocated_bytes	= 0;
+}
+
+// =================================================================
+//	Allocates a block of memory from the arena.
+// =================================================================
+void* CArena::Allocate(size_t size)
+{
+	size = (size + (ARENA_ALIGNMENT - 1)) & ~((size_t)ARENA_ALIGNMENT - 1);
+
+	m_allocation_count++;
+	m_allocated_bytes += size;
+
+	// Large allocations get a block to themselves so we don't waste
+	// the remainder of a chunk.
+	if (size > ARENA_CHUNK_SIZE / 4)
+	{
+		char* block = (char*)malloc(size);
+		if (block == NULL)
+		{
+			throw std::bad_alloc();
+		}
+		m_large_allocations.push_back(block);
+		return block;
+	}
+
+	// Grab a new chunk if this one is full.
+	if (m_chunk_position == NULL || (size_t)(m_chunk_end - m_chunk_position) < size)
+	{
+		char* chunk = NULL;
+		if (g_free_chunks.size() > 0)
+		{
+			chunk = g_free_chunks.back();
+			g_free_chunks.pop_back();
+		}
+		else
+		{
+			chunk = (char*)malloc(ARENA_CHUNK_SIZE);
+			if (chunk == NULL)
+			{
+				throw std::bad_alloc();
+			}
+		}
+
+		m_chunks.push_back(chunk);
+		m_chunk_position = chunk;
+		m_chunk_end		 = chunk + ARENA_CHUNK_SIZE;
+	}
+
+	void* result = m_chunk_position;
+	m_chunk_position += size;
+
+	return result;
+}
+
+// =================================================================
+//	Gets the number of allocations made from this arena.
+// =================================================================
+int CArena::GetAllocationCount()
+{
+	return m_allocation_count;
+}
+
+// =================================================================
+//	Gets the number of bytes allocated from this arena.
+// =================================================================
+size_t CArena::GetAllocatedBytes()
+{
+	return m_allocated_bytes;
+}
+
+// =================================================================
+//	Gets the number of chunks this arena is using.
+// =================================================================
+int CArena::GetChunkCount()
+{
+	return m_chunks.size();
+}
+
+// =================================================================
+//	Gets the arena that objects are currently being allocated from.
+// =================================================================
+CArena* CArena::GetCurrent()
+{
+	return g_current_arena;
+}
+
+// =================================================================
+//	Sets the arena that objects are allocated from, returns the
+//	previous arena.
+// =================================================================
+CArena* CArena::SetCurrent(CArena* arena)
+{
+	CArena* previous = g_current_arena;
+	g_current_arena = arena;
+	return previous;
+}
+
+// =================================================================
+//	Allocates memory for an object from the current arena, or the
+//	heap if there is none. A header is stored just before the object
+//	recording the arena it came from, and how to destroy it if it is
+//	still alive when the arena is released.
+// =================================================================
+void* CArena::AllocateObject(size_t size, CArenaDestructor destructor)
+{
+	char* block = NULL;
+
+	if (g_current_arena != NULL)
+	{
+		block = (char*)g_current_arena->Allocate(size + ARENA_ALIGNMENT);
+		g_current_arena->m_objects.push_back(block);
+	}
+	else
+	{
+		block = (char*)malloc(size + ARENA_ALIGNMENT);
+		if (block == NULL)
+		{
+			throw std::bad_alloc();
+		}
+	}
+
+	CArenaObjectHeader* header = (CArenaObjectHeader*)block;
+	header->Arena		= g_current_arena;
+	header->Destructor	= destructor;
+
+	return block + ARENA_ALIGNMENT;
+}
+
+// =================================================================
+//	Frees an object allocated with AllocateObject, once it has been
+//	destroyed. Objects from an arena keep their memory until the
+//	arena is released, but are not destroyed again.
+// =================================================================
+void CArena::FreeObject(void* ptr)
+{
+	if (ptr == NULL)
+	{
+		return;
+	}
+
+	char* block = ((char*)ptr) - ARENA_ALIGNMENT;
+	CArenaObjectHeader* header = (CArenaObjectHeader*)block;
+	if (header->Arena == NULL)
+	{
+		free(block);
+	}
+	else
+	{
+		header->Destructor = NULL;
+	}
+}
+
+// =================================================================
+//	Makes the given arena current.
+// =================================================================
+CArenaScope::CArenaScope(CArena* arena)
+{
+	m_previous = CArena::SetCurrent(arena);
+}
+
+// =================================================================
+//	Restores the previously current arena.
+// =================================================================
+CArenaScope::~CArenaScope()
+{
+	CArena::SetCurrent(m_previous);
+}
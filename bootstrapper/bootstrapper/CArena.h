@@ -0,0 +1,93 @@
+/* *****************************************************************
+
+		CArena.h
+
+		Copyright (C) 2012 Tim Leonard - All Rights Reserved
+
+   ***************************************************************** */
+#pragma once
+#ifndef _CARENA_H_
+#define _CARENA_H_
+
+#include <stddef.h>
+#include <vector>
+
+// Size of each block of memory the arena hands out allocations from.
+#define ARENA_CHUNK_SIZE		(256 * 1024)
+
+// Every allocation is aligned to this boundary.
+#define ARENA_ALIGNMENT			16
+
+class CArena;
+
+// Destroys an object allocated from an arena without freeing its memory.
+typedef void (*CArenaDestructor)(void* ptr);
+
+// =================================================================
+//	Stored just before every object allocated with AllocateObject.
+// =================================================================
+struct CArenaObjectHeader
+{
+	CArena*				Arena;
+	CArenaDestructor	Destructor;
+};
+
+// =================================================================
+//	Bump allocator that AST nodes and data types are allocated
+//	from during a compile. The arena owns everything allocated 
+//	from it. When it is released the destructors of any objects
+//	that have not already been deleted are run, then everything is
+//	freed in one go and chunks are kept on a free list to be 
+//	recycled by the next arena.
+// =================================================================
+class CArena
+{
+private:
+	static CArena*				g_current_arena;
+	static std::vector<char*>	g_free_chunks;
+
+	std::vector<char*>			m_chunks;
+	std::vector<char*>			m_large_allocations;
+	std::vector<char*>			m_objects;
+	char*						m_chunk_position;
+	char*						m_chunk_end;
+
+	int							m_allocation_count;
+	size_t						m_allocated_bytes;
+
+	void*		Allocate			(size_t size);
+
+public:
+	CArena();
+	~CArena();
+
+	void		Release				();
+
+	int			GetAllocationCount	();
+	size_t		GetAllocatedBytes	();
+	int			GetChunkCount		();
+
+	static CArena*	GetCurrent		();
+	static CArena*	SetCurrent		(CArena* arena);
+
+	static void*	AllocateObject	(size_t size, CArenaDestructor destructor);
+	static void		FreeObject		(void* ptr);
+
+};
+
+// =================================================================
+//	Makes the given arena current for the lifetime of the scope
+//	it is declared in.
+// =================================================================
+class CArenaScope
+{
+private:
+	CArena*	m_previous;
+
+public:
+	CArenaScope(CArena* arena);
+	~CArenaScope();
+
+};
+
+#endif
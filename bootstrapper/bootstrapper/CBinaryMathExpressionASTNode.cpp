@@ -8,6 +8,8 @@
 
 #include "CBinaryMathExpressionASTNode.h"
 
+#include <limits.h>
+
 #include "CStringHelper.h"
 
 #include "CSemanter.h"
@@ -122,6 +124,49 @@ CASTNode* CBinaryMathExpressionASTNode::Semant(CSemanter* semanter)
 	LeftValue  = ReplaceChild(LeftValue,  leftValueBase->CastTo(semanter, ExpressionResultType, Token));
 	RightValue = ReplaceChild(RightValue, rightValueBase->CastTo(semanter, ExpressionResultType, Token)); 
 
+	// Fold constant expressions, as long as they would not fault at runtime.
+	if (semanter->IsConstant(LeftValue) && semanter->IsConstant(RightValue))
+	{
+		EvaluationResult rightResult = RightValue->Evaluate(semanter->GetContext());
+
+		switch (Token.Type)
+		{
+			case TokenIdentifier::OP_DIV:
+			case TokenIdentifier::OP_MOD:
+			{
+				if (dynamic_cast<CFloatDataType*>(ExpressionResultType) != NULL ? rightResult.GetFloat() == 0.0f : rightResult.GetInt() == 0)
+				{
+					return this;
+				}
+
+				// The smallest int divided by -1 overflows, which traps just
+				// like dividing by zero does.
+				if (dynamic_cast<CIntDataType*>(ExpressionResultType) != NULL &&
+					rightResult.GetInt() == -1 &&
+					LeftValue->Evaluate(semanter->GetContext()).GetInt() == INT_MIN)
+				{
+					return this;
+				}
+				break;
+			}
+			case TokenIdentifier::OP_SHL:
+			case TokenIdentifier::OP_SHR:
+			{
+				if (rightResult.GetInt() < 0 || rightResult.GetInt() > 31)
+				{
+					return this;
+				}
+				break;
+			}
+			default:
+			{
+				break;
+			}
+		}
+
+		return semanter->FoldConstant(this);
+	}
+
 	return this;
 }
 
@@ -80,19 +80,21 @@
 #include "CClassReferenceDataType.h"
 
 #include <stdarg.h> 
+#include <string.h>
+#include <algorithm>
 
 // =================================================================
 //	Closes the source file.
 // =================================================================
 CCPPTranslator::CCPPTranslator() :
-	m_source_indent_level(0),
-	m_header_indent_level(0),
+	m_array_accesses(0),
+	m_unchecked_array_accesses(0),
+	m_stack_allocation(NULL),
+	m_stack_storage(""),
+	m_inline_threshold(0),
+	m_scratch_depth(0),
 	m_include_guard(""),
-	m_last_source_was_newline(false),
-	m_last_header_was_newline(false),
 	m_internal_var_counter(0),
-	m_source_source(""),
-	m_header_source(""),
 	m_switchBreakJumpLabel(""),
 	m_last_gc_collect_emit(0),
 	m_emit_source_counter(0)
@@ -152,15 +154,17 @@ void CCPPTranslator::OpenHeaderFile(std::string path)
 // =================================================================
 void CCPPTranslator::CloseSourceFile()
 {
+	CProfileScope scope(m_context->GetCompiler()->GetProfiler(), "file write", "", m_source_file_path);
+
 	std::string output;
 
 	CPathHelper::LoadFile(m_source_file_path, output);
-	if (output != m_source_source)
+	if (output != m_source.GetText())
 	{		
-		CPathHelper::SaveFile(m_source_file_path, m_source_source);
+		CPathHelper::SaveFile(m_source_file_path, m_source.GetText());
 	}
 
-	m_source_source = "";
+	m_source.Clear();
 }
 
 // =================================================================
@@ -171,102 +175,174 @@ void CCPPTranslator::CloseHeaderFile()
 	EmitHeaderFile("#endif // %s\n", m_include_guard.c_str());
 	EmitHeaderFile("\n");
 
+	CProfileScope scope(m_context->GetCompiler()->GetProfiler(), "file write", "", m_header_file_path);
+
 	std::string output;
 
 	CPathHelper::LoadFile(m_header_file_path, output);
-	if (output != m_header_source)
+	if (output != m_header.GetText())
 	{
-		CPathHelper::SaveFile(m_header_file_path, m_header_source);
+		CPathHelper::SaveFile(m_header_file_path, m_header.GetText());
 	}
 
-	m_header_source = "";
+	m_header.Clear();
 }
 
 // =================================================================
-//	Writes a piece of text to the given source file.
+//	Opens the inline file. This is a header holding the definitions
+//	of a class's small methods, included by every source file that
+//	calls them so they can be inlined across classes.
 // =================================================================
-void CCPPTranslator::EmitSourceFile(std::string text, ...)
+void CCPPTranslator::OpenInlineFile(std::string path, CClassASTNode* node)
 {
-	if (text[0] == '{')
-	{	
-		if (m_last_source_was_newline == true)
+	m_inline_file_path = (path + ".inline.hpp");
+
+	std::string relative = CPathHelper::GetRelativePath(path, m_source_directory);
+	std::string guard	 = CStringHelper::ToUpper("__" + CStringHelper::CleanExceptAlphaNum(relative, '_') + "_INLINE__");
+
+	m_inline.Emit("/* *****************************************************************\n");
+	m_inline.Emit("          LudumScribe Compiler\n");
+	m_inline.Emit("   ***************************************************************** */\n");
+	m_inline.Emit("\n");
+	m_inline.Emit("#ifndef " + guard + "\n");
+	m_inline.Emit("#define " + guard + "\n");
+	m_inline.Emit("\n");
+	m_inline.Emit("#include \"" + relative + ".hpp\"\n");
+
+	// Include everything the inlined methods reference.
+	std::unordered_set<CClassASTNode*> references;
+	for (std::vector<CASTNode*>::iterator iter = node->Body->Children.begin(); iter != node->Body->Children.end(); iter++)
+	{
+		CClassMemberASTNode* member = dynamic_cast<CClassMemberASTNode*>(*iter);
+		if (member != NULL && m_inline_methods.find(member) != m_inline_methods.end())
 		{
-			text = CStringHelper::MultiplyString("\t", m_source_indent_level) + text;
+			FindReferencedClasses(member, references);
 		}
-		m_source_indent_level++;
 	}
-	else if (text[0] == '}')
+
+	std::vector<CClassASTNode*> classes;
+	GetTranslatedClasses(classes);
+
+	std::unordered_set<CClassASTNode*> inline_classes;
+	for (std::vector<CClassASTNode*>::iterator iter = classes.begin(); iter != classes.end(); iter++)
 	{
-		m_source_indent_level--;
-		if (m_last_source_was_newline == true)
+		if (*iter != node && references.find(*iter) != references.end())
 		{
-			text = CStringHelper::MultiplyString("\t", m_source_indent_level) + text;
+			m_inline.Emit("#include \"" + (*iter)->MangledIdentifier + ".hpp\"\n");
+			AddInlineClasses(*iter, inline_classes);
 		}
 	}
-	else
+	for (std::vector<CClassASTNode*>::iterator iter = classes.begin(); iter != classes.end(); iter++)
 	{
-		if (m_last_source_was_newline == true)
+		if (*iter != node && inline_classes.find(*iter) != inline_classes.end())
 		{
-			text = CStringHelper::MultiplyString("\t", m_source_indent_level) + text;
+			m_inline.Emit("#include \"" + (*iter)->MangledIdentifier + ".inline.hpp\"\n");
 		}
 	}
-	
-	m_last_source_was_newline = false;
-	if (text[text.size() - 1] == '\n')
+	m_inline.Emit("\n");
+
+	m_created_files.push_back(path + ".inline.hpp");
+}
+
+// =================================================================
+//	Closes the inline file.
+// =================================================================
+void CCPPTranslator::CloseInlineFile()
+{
+	m_inline.Emit("#endif\n");
+	m_inline.Emit("\n");
+
+	CProfileScope scope(m_context->GetCompiler()->GetProfiler(), "file write", "", m_inline_file_path);
+
+	std::string output;
+
+	CPathHelper::LoadFile(m_inline_file_path, output);
+	if (output != m_inline.GetText())
 	{
-		m_last_source_was_newline = true;
+		CPathHelper::SaveFile(m_inline_file_path, m_inline.GetText());
 	}
 
-	va_list vl;
-	va_start(vl, text);
-	text = CStringHelper::FormatStringVarArgs(text, vl);
-	va_end(vl);
+	m_inline.Clear();
+}
+
+// =================================================================
+//	Writes a piece of text to the given source file. Text without
+//	format specifiers is written without being formatted.
+// =================================================================
+void CCPPTranslator::EmitSourceFile(const char* text, ...)
+{
+	if (strchr(text, '%') == NULL)
+	{
+		m_source.Emit(text, strlen(text));
+	}
+	else
+	{
+		va_list vl;
+		va_start(vl, text);
+		m_source.EmitFormat(text, vl);
+		va_end(vl);
+	}
+	m_emit_source_counter++;
+}
 
-	m_source_source += text;
+// =================================================================
+//	Writes a piece of text to the given source file as-is.
+// =================================================================
+void CCPPTranslator::EmitSourceFile(const std::string& text)
+{
+	m_source.Emit(text);
 	m_emit_source_counter++;
 }
 
 // =================================================================
-//	Writes a piece of text to the given header file.
+//	Writes a piece of text to the given header file. Text without
+//	format specifiers is written without being formatted.
 // =================================================================
-void CCPPTranslator::EmitHeaderFile(std::string text, ...)
+void CCPPTranslator::EmitHeaderFile(const char* text, ...)
 {	
-	if (text[0] == '{')
-	{
-		if (m_last_header_was_newline == true)
-		{
-			text = CStringHelper::MultiplyString("\t", m_header_indent_level) + text;
-		}
-		m_header_indent_level++;
-	}
-	else if (text[0] == '}')
+	if (strchr(text, '%') == NULL)
 	{
-		m_header_indent_level--;
-		if (m_last_header_was_newline == true)
-		{
-			text = CStringHelper::MultiplyString("\t", m_header_indent_level) + text;
-		}
+		m_header.Emit(text, strlen(text));
 	}
 	else
 	{
-		if (m_last_header_was_newline == true)
-		{
-			text = CStringHelper::MultiplyString("\t", m_header_indent_level) + text;
-		}
+		va_list vl;
+		va_start(vl, text);
+		m_header.EmitFormat(text, vl);
+		va_end(vl);
 	}
-	
-	m_last_header_was_newline = false;
-	if (text != "" && text[text.size() - 1] == '\n')
+}
+
+// =================================================================
+//	Writes a piece of text to the given header file as-is.
+// =================================================================
+void CCPPTranslator::EmitHeaderFile(const std::string& text)
+{	
+	m_header.Emit(text);
+}
+
+// =================================================================
+//	Gets an empty scratch string to build an expression in. Strings
+//	are kept for reuse so they only allocate when they need to grow.
+// =================================================================
+std::string& CCPPTranslator::AcquireScratch()
+{
+	if (m_scratch_depth >= (int)m_scratch.size())
 	{
-		m_last_header_was_newline = true;
+		m_scratch.push_back("");
 	}
 
-	va_list vl;
-	va_start(vl, text);
-	text = CStringHelper::FormatStringVarArgs(text, vl);
-	va_end(vl);
-	
-	m_header_source += text;
+	std::string& result = m_scratch[m_scratch_depth++];
+	result.clear();
+	return result;
+}
+
+// =================================================================
+//	Returns the last scratch string that was acquired.
+// =================================================================
+void CCPPTranslator::ReleaseScratch()
+{
+	m_scratch_depth--;
 }
 
 // =================================================================
@@ -360,105 +436,824 @@ std::string CCPPTranslator::EscapeCString(std::string val)
 			result += "\\x" + CStringHelper::ToHexString((int)chr);
 		}
 	}
-	return result;
+	return result;
+}
+
+// =================================================================
+//	Encloses an expression string with parenthesis if they are 
+//	required.
+// =================================================================
+std::string CCPPTranslator::Enclose(const std::string& val)
+{
+//	if (val[0] == '(' && val[val.size() - 1] == ')')
+//	{
+//		return val;
+//	}
+
+	std::string result;
+	result.reserve(val.size() + 2);
+	result += '(';
+	result += val;
+	result += ')';
+	return result;
+}
+
+// =================================================================
+//	Returns true if the given string is a keyword. This is used to
+//	ignore trying to forward-declare classes that are keywords.
+// =================================================================
+bool CCPPTranslator::IsKeyword(std::string value)
+{
+	if (value == "bool" ||
+		value == "int" ||
+		value == "float")
+	{
+		return true;
+	}
+
+	return false;
+}
+
+// =================================================================
+//	Emits all includes required for a class declaration.
+// =================================================================
+void CCPPTranslator::EmitRequiredClassIncludes(CClassASTNode* node)
+{
+	if (node->SuperClass != NULL)
+	{
+		if (node->SuperClass->IsNative == false)
+		{		
+			std::string path = node->SuperClass->MangledIdentifier;
+			EmitHeaderFile("#include \"%s.hpp\"\n", path.c_str());
+		}
+	}
+
+	for (std::vector<CClassASTNode*>::iterator  iter = node->Interfaces.begin(); iter != node->Interfaces.end(); iter++)
+	{
+		CClassASTNode* interfaceNode = *iter;
+		if (interfaceNode->IsNative == false)
+		{		
+			std::string path = interfaceNode->MangledIdentifier;
+			EmitHeaderFile("#include \"%s.hpp\"\n", path.c_str());
+		}
+	}
+
+	EmitHeaderFile("\n");
+}
+
+// =================================================================
+//	Adds the classes a data type needs to be translated to the 
+//	given set. Primitive types also reference their box class as
+//	casts and type checks are translated using it.
+// =================================================================
+void CCPPTranslator::AddReferencedDataType(CDataType* type, std::unordered_set<CClassASTNode*>& references)
+{
+	if (type == NULL)
+	{
+		return;
+	}
+
+	CArrayDataType* arrayType = dynamic_cast<CArrayDataType*>(type);
+	if (arrayType != NULL)
+	{
+		references.insert(arrayType->GetClass(m_semanter));
+		AddReferencedDataType(arrayType->ElementType, references);
+	}
+	else if (dynamic_cast<CObjectDataType*>(type)			!= NULL ||
+			 dynamic_cast<CClassReferenceDataType*>(type)	!= NULL)
+	{
+		references.insert(type->GetClass(m_semanter));
+	}
+	else if (dynamic_cast<CBoolDataType*>(type)		!= NULL ||
+			 dynamic_cast<CIntDataType*>(type)		!= NULL ||
+			 dynamic_cast<CFloatDataType*>(type)	!= NULL ||
+			 dynamic_cast<CStringDataType*>(type)	!= NULL)
+	{
+		// Primitive types are used by name, so look them up once.
+		std::string name = type->ToString();
+
+		std::map<std::string, CClassASTNode*>::iterator iter = m_primitive_classes.find(name);
+		if (iter == m_primitive_classes.end())
+		{
+			m_primitive_classes.insert(std::pair<std::string, CClassASTNode*>(name, type->GetClass(m_semanter)));
+			m_primitive_classes.insert(std::pair<std::string, CClassASTNode*>(name + "#box", type->GetBoxClass(m_semanter)));
+		}
+
+		references.insert(m_primitive_classes[name]);
+		references.insert(m_primitive_classes[name + "#box"]);
+	}
+}
+
+// =================================================================
+//	Finds all class referenced by a given node and its children,
+//	from the data types of declarations and the result types of
+//	expressions.
+// =================================================================
+void CCPPTranslator::FindReferencedClasses(CASTNode* node, std::unordered_set<CClassASTNode*>& references)
+{
+	if (node == NULL)
+	{
+		return;
+	}
+
+	// Class references?
+	CClassASTNode* classNode = dynamic_cast<CClassASTNode*>(node);
+	if (classNode != NULL)
+	{
+		references.insert(classNode->SuperClass);
+		for (std::vector<CClassASTNode*>::iterator iter = classNode->Interfaces.begin(); iter != classNode->Interfaces.end(); iter++)
+		{
+			references.insert(*iter);
+		}
+
+		FindReferencedClasses(classNode->Body, references);
+		return;
+	}
+
+	// Member declarations.
+	CClassMemberASTNode* memberNode = dynamic_cast<CClassMemberASTNode*>(node);
+	if (memberNode != NULL)
+	{
+		if (memberNode->IsReachable == false)
+		{
+			return;
+		}
+
+		AddReferencedDataType(memberNode->ReturnType, references);
+
+		for (std::vector<CVariableStatementASTNode*>::iterator iter = memberNode->Arguments.begin(); iter != memberNode->Arguments.end(); iter++)
+		{
+			if (std::find(node->Children.begin(), node->Children.end(), *iter) == node->Children.end())
+			{
+				FindReferencedClasses(*iter, references);
+			}
+		}
+		if (std::find(node->Children.begin(), node->Children.end(), memberNode->Assignment) == node->Children.end())
+		{
+			FindReferencedClasses(memberNode->Assignment, references);
+		}
+		if (std::find(node->Children.begin(), node->Children.end(), memberNode->Body) == node->Children.end())
+		{
+			FindReferencedClasses(memberNode->Body, references);
+		}
+	}
+
+	// Variable declarations.
+	CVariableStatementASTNode* variableNode = dynamic_cast<CVariableStatementASTNode*>(node);
+	if (variableNode != NULL)
+	{
+		AddReferencedDataType(variableNode->Type, references);
+	}
+
+	// Expression result types.
+	CExpressionBaseASTNode* exprNode = dynamic_cast<CExpressionBaseASTNode*>(node);
+	if (exprNode != NULL)
+	{
+		AddReferencedDataType(exprNode->ExpressionResultType, references);
+
+		CCastExpressionASTNode* castNode = dynamic_cast<CCastExpressionASTNode*>(node);
+		if (castNode != NULL)
+		{
+			AddReferencedDataType(castNode->Type, references);
+		}
+
+		CTypeExpressionASTNode* typeNode = dynamic_cast<CTypeExpressionASTNode*>(node);
+		if (typeNode != NULL)
+		{
+			AddReferencedDataType(typeNode->Type, references);
+		}
+
+		CNewExpressionASTNode* newNode = dynamic_cast<CNewExpressionASTNode*>(node);
+		if (newNode != NULL)
+		{
+			AddReferencedDataType(newNode->DataType, references);
+		}
+
+		CMethodCallExpressionASTNode* callNode = dynamic_cast<CMethodCallExpressionASTNode*>(node);
+		if (callNode != NULL && callNode->StackAllocation != NULL)
+		{
+			AddReferencedDataType(callNode->StackAllocation->DataType, references);
+		}
+
+		CComparisonExpressionASTNode* compareNode = dynamic_cast<CComparisonExpressionASTNode*>(node);
+		if (compareNode != NULL)
+		{
+			AddReferencedDataType(compareNode->CompareResultType, references);
+		}
+	}
+
+	// Grab references made by children.
+	for (std::vector<CASTNode*>::iterator iter = node->Children.begin(); iter != node->Children.end(); iter++)
+	{
+		FindReferencedClasses(*iter, references);
+	}
+}
+
+// =================================================================
+//	Emits forward declarations to the header and includes to the
+//	source file for each class in the given set, or every class if
+//	node is NULL. Classes are emitted in package order so output is
+//	stable between builds.
+// =================================================================
+void CCPPTranslator::EmitReferencedClasses(CClassASTNode* node, std::unordered_set<CClassASTNode*>& references)
+{
+	std::vector<CClassASTNode*> classes;
+	GetTranslatedClasses(classes);
+
+	std::unordered_set<CClassASTNode*> inline_classes;
+	if (node != NULL)
+	{
+		AddInlineClasses(node, inline_classes);
+	}
+
+	for (std::vector<CClassASTNode*>::iterator iter = classes.begin(); iter != classes.end(); iter++)
+	{
+		CClassASTNode* child = *iter;
+		if (child == node ||
+			(node != NULL && references.find(child) == references.end()))
+		{
+			continue;
+		}
+
+		if (!IsKeyword(child->MangledIdentifier))
+		{
+			EmitHeaderFile("class %s;\n", child->MangledIdentifier.c_str());
+		}
+				
+		std::string path = child->MangledIdentifier;
+		EmitSourceFile("#include \"%s.hpp\"\n", path.c_str());
+
+		AddInlineClasses(child, inline_classes);
+	}
+
+	// Include the definitions of any methods we may be inlining.
+	for (std::vector<CClassASTNode*>::iterator iter = classes.begin(); iter != classes.end(); iter++)
+	{
+		if (inline_classes.find(*iter) != inline_classes.end())
+		{
+			EmitSourceFile("#include \"%s.inline.hpp\"\n", (*iter)->MangledIdentifier.c_str());
+		}
+	}
+
+	EmitHeaderFile("\n");
+	EmitSourceFile("\n");
+}
+
+// =================================================================
+//	Gets every class that is translated, in package order.
+// =================================================================
+void CCPPTranslator::GetTranslatedClasses(std::vector<CClassASTNode*>& classes)
+{
+	for (std::vector<CASTNode*>::iterator iter = m_package->Children.begin(); iter != m_package->Children.end(); iter++)
+	{
+		CClassASTNode* child = dynamic_cast<CClassASTNode*>(*iter);
+		if (child == NULL)
+		{
+			continue;
+		}
+		if (child->IsGeneric == true)
+		{
+			for (std::vector<CClassASTNode*>::iterator iter2 = child->GenericInstances.begin(); iter2 != child->GenericInstances.end(); iter2++)
+			{
+				if ((*iter2)->IsReachable == true)
+				{
+					classes.push_back(*iter2);
+				}
+			}
+		}
+		else if (child->IsReachable == true)
+		{
+			classes.push_back(child);
+		}
+	}
+}
+
+// =================================================================
+//	Works out which methods are small enough to be defined in an
+//	inline file. Only methods that are never called virtually are
+//	considered, the others could not be inlined anyway.
+// =================================================================
+void CCPPTranslator::FindInlineMethods()
+{
+	m_inline_methods.clear();
+	m_inline_classes.clear();
+
+	if (m_inline_threshold <= 0)
+	{
+		return;
+	}
+
+	std::vector<CClassASTNode*> classes;
+	GetTranslatedClasses(classes);
+
+	int methods = 0;
+	for (std::vector<CClassASTNode*>::iterator iter = classes.begin(); iter != classes.end(); iter++)
+	{
+		CClassASTNode* classNode = *iter;
+		if (classNode->IsInterface == true)
+		{
+			continue;
+		}
+
+		// Native code declares the methods of native classes it uses 
+		// itself, so they always need an out of line definition.
+		if (classNode->IsNative == true)
+		{
+			continue;
+		}
+
+		for (std::vector<CASTNode*>::iterator iter2 = classNode->Body->Children.begin(); iter2 != classNode->Body->Children.end(); iter2++)
+		{
+			CClassMemberASTNode* member = dynamic_cast<CClassMemberASTNode*>(*iter2);
+			if (member == NULL ||
+				member->IsReachable == false ||
+				member->MemberType != MemberType::Method ||
+				member->Body == NULL ||
+				member->IsNative == true ||
+				member->IsAbstract == true)
+			{
+				continue;
+			}
+
+			methods++;
+			if (member->IsVirtual == true && (member->IsOverridden == true || member->HasBaseMember == true))
+			{
+				continue;
+			}
+
+			int cost = 0;
+			if (CountInlineCost(member->Body, member, cost) == true)
+			{
+				m_inline_methods.insert(member);
+				m_inline_classes.insert(classNode);
+			}
+		}
+	}
+
+	m_context->Info(CStringHelper::FormatString("Defined %i of %i methods inline.", (int)m_inline_methods.size(), methods));
+}
+
+// =================================================================
+//	Counts the statements and expressions in a method body. Returns
+//	false if the method is recursive or is over the inline threshold.
+// =================================================================
+bool CCPPTranslator::CountInlineCost(CASTNode* node, CClassMemberASTNode* method, int& cost)
+{
+	CMethodCallExpressionASTNode* callNode = dynamic_cast<CMethodCallExpressionASTNode*>(node);
+	if (callNode != NULL && callNode->ResolvedDeclaration == method)
+	{
+		return false;
+	}
+
+	if (dynamic_cast<CMethodBodyASTNode*>(node)		== NULL &&
+		dynamic_cast<CBlockStatementASTNode*>(node) == NULL &&
+		dynamic_cast<CExpressionASTNode*>(node)		== NULL)
+	{
+		cost++;
+		if (cost > m_inline_threshold)
+		{
+			return false;
+		}
+	}
+
+	for (std::vector<CASTNode*>::iterator iter = node->Children.begin(); iter != node->Children.end(); iter++)
+	{
+		if (CountInlineCost(*iter, method, cost) == false)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// =================================================================
+//	Adds the class and the classes it derives from to the given set
+//	if they have an inline file.
+// =================================================================
+void CCPPTranslator::AddInlineClasses(CClassASTNode* node, std::unordered_set<CClassASTNode*>& classes)
+{
+	for (; node != NULL; node = node->SuperClass)
+	{
+		if (m_inline_classes.find(node) != m_inline_classes.end())
+		{
+			classes.insert(node);
+		}
+	}
+}
+
+// =================================================================
+//	Gives every translated class a type id. Ids are assigned in
+//	pre-order down the class tree so each class and all classes 
+//	derived from it cover a contiguous range, which lets casts be
+//	checked with a single range comparison.
+// =================================================================
+void CCPPTranslator::AssignTypeIDs(CPackageASTNode* node)
+{
+	std::vector<CClassASTNode*>											 classes;
+	std::unordered_map<CClassASTNode*, std::vector<CClassASTNode*> >	 subclasses;
+
+	m_type_ranges.clear();
+
+	for (std::vector<CASTNode*>::iterator iter = node->Children.begin(); iter != node->Children.end(); iter++)
+	{
+		CClassASTNode* child = dynamic_cast<CClassASTNode*>(*iter);
+		if (child == NULL)
+		{
+			continue;
+		}
+		if (child->IsGeneric == true)
+		{
+			for (std::vector<CClassASTNode*>::iterator iter2 = child->GenericInstances.begin(); iter2 != child->GenericInstances.end(); iter2++)
+			{
+				classes.push_back(*iter2);
+			}
+		}
+		else
+		{
+			classes.push_back(child);
+		}
+	}
+
+	for (std::vector<CClassASTNode*>::iterator iter = classes.begin(); iter != classes.end(); iter++)
+	{
+		CClassASTNode* classNode = *iter;
+		if (classNode->IsReachable == false ||
+			classNode->IsNative == true ||
+			classNode->IsInterface == true)
+		{
+			continue;
+		}
+
+		// Classes derived from native classes start a new tree.
+		CClassASTNode* super = classNode->SuperClass;
+		if (super == NULL || super->IsNative == true)
+		{
+			super = NULL;
+		}
+		subclasses[super].push_back(classNode);
+	}
+
+	// Id 0 is left for native classes, which never pass a range check.
+	AssignTypeID(NULL, 0, subclasses);
+}
+
+// =================================================================
+//	Assigns an id to a class and all classes derived from it, returns
+//	the next free id.
+// =================================================================
+int CCPPTranslator::AssignTypeID(CClassASTNode* node, int next_id, std::unordered_map<CClassASTNode*, std::vector<CClassASTNode*> >& subclasses)
+{
+	int first_id = next_id++;
+
+	std::unordered_map<CClassASTNode*, std::vector<CClassASTNode*> >::iterator iter = subclasses.find(node);
+	if (iter != subclasses.end())
+	{
+		for (std::vector<CClassASTNode*>::iterator iter2 = iter->second.begin(); iter2 != iter->second.end(); iter2++)
+		{
+			next_id = AssignTypeID(*iter2, next_id, subclasses);
+		}
+	}
+
+	if (node != NULL)
+	{
+		m_type_ranges.insert(std::pair<CClassASTNode*, std::pair<int, int> >(node, std::pair<int, int>(first_id, next_id - 1)));
+	}
+
+	return next_id;
+}
+
+// =================================================================
+//	Translates a checked cast between two object types. Casts to
+//	classes with a type id are a range check, casts to or from
+//	interfaces go through the RTTI.
+// =================================================================
+std::string CCPPTranslator::TranslateClassCast(CDataType* fromType, CDataType* toType, std::string expr, bool exception_on_fail)
+{
+	CClassASTNode* fromClass = fromType->GetClass(m_semanter);
+	CClassASTNode* toClass	 = toType->GetClass(m_semanter);
+
+	if (fromClass->IsInterface == false &&
+		dynamic_cast<CArrayDataType*>(toType) == NULL &&
+		m_type_ranges.find(toClass) != m_type_ranges.end())
+	{
+		return "lsClassCast<" + toClass->MangledIdentifier + ">(" + Enclose(expr) + ", " + (exception_on_fail ? "true" : "false") + ")";
+	}
+
+	return "lsCast<" + TranslateDataType(toType) + ">(" + Enclose(expr) + ", " + (exception_on_fail ? "true" : "false") + ")";
+}
+
+// =================================================================
+//	Gets the local variable or parameter an expression refers to,
+//	or NULL if it refers to anything else.
+// =================================================================
+CVariableStatementASTNode* CCPPTranslator::GetLocalVariable(CASTNode* node)
+{
+	while (dynamic_cast<CExpressionASTNode*>(node) != NULL)
+	{
+		node = dynamic_cast<CExpressionASTNode*>(node)->LeftValue;
+	}
+
+	CIdentifierExpressionASTNode* identifier = dynamic_cast<CIdentifierExpressionASTNode*>(node);
+	if (identifier == NULL)
+	{
+		return NULL;
+	}
+
+	return identifier->ExpressionResultVariable;
+}
+
+// =================================================================
+//	Returns true if this is a loop of the form:
+//
+//		for (int i = 0; i < arr.Length(); i++)
+//
+//	where neither i or arr are modified in the body, in which case
+//	every arr[i] in the body is in bounds.
+// =================================================================
+bool CCPPTranslator::IsBoundedIndexLoop(CForStatementASTNode* node, CVariableStatementASTNode*& array, CVariableStatementASTNode*& index)
+{
+	// int i = <non-negative literal>
+	index = dynamic_cast<CVariableStatementASTNode*>(node->InitialStatement);
+	if (index == NULL ||
+		dynamic_cast<CIntDataType*>(index->Type) == NULL ||
+		index->AssignmentExpression == NULL)
+	{
+		return false;
+	}
+
+	CASTNode* initial = index->AssignmentExpression;
+	while (dynamic_cast<CExpressionASTNode*>(initial) != NULL)
+	{
+		initial = dynamic_cast<CExpressionASTNode*>(initial)->LeftValue;
+	}
+
+	CLiteralExpressionASTNode* literal = dynamic_cast<CLiteralExpressionASTNode*>(initial);
+	if (literal == NULL ||
+		dynamic_cast<CIntDataType*>(literal->ExpressionResultType) == NULL ||
+		literal->Evaluate(m_context).GetInt() < 0)
+	{
+		return false;
+	}
+
+	// i < arr.Length()
+	CASTNode* condition = node->ConditionExpression;
+	while (dynamic_cast<CExpressionASTNode*>(condition) != NULL)
+	{
+		condition = dynamic_cast<CExpressionASTNode*>(condition)->LeftValue;
+	}
+
+	CComparisonExpressionASTNode* comparison = dynamic_cast<CComparisonExpressionASTNode*>(condition);
+	if (comparison == NULL ||
+		comparison->Token.Type != TokenIdentifier::OP_LESS ||
+		GetLocalVariable(comparison->LeftValue) != index)
+	{
+		return false;
+	}
+
+	CMethodCallExpressionASTNode* length = dynamic_cast<CMethodCallExpressionASTNode*>(comparison->RightValue);
+	CClassMemberASTNode*		  member = length == NULL ? NULL : dynamic_cast<CClassMemberASTNode*>(length->ResolvedDeclaration);
+	if (member == NULL ||
+		member->IsNative == false ||
+		member->Identifier != "Length")
+	{
+		return false;
+	}
+
+	array = GetLocalVariable(length->LeftValue);
+	if (array == NULL ||
+		dynamic_cast<CArrayDataType*>(array->Type) == NULL)
+	{
+		return false;
+	}
+
+	// i++ or ++i
+	CASTNode* increment = node->IncrementExpression;
+	while (dynamic_cast<CExpressionASTNode*>(increment) != NULL)
+	{
+		increment = dynamic_cast<CExpressionASTNode*>(increment)->LeftValue;
+	}
+
+	CPostFixExpressionASTNode* postfix = dynamic_cast<CPostFixExpressionASTNode*>(increment);
+	CPreFixExpressionASTNode*  prefix  = dynamic_cast<CPreFixExpressionASTNode*>(increment);
+	if (!(postfix != NULL && postfix->Token.Type == TokenIdentifier::OP_INCREMENT && GetLocalVariable(postfix->LeftValue) == index) &&
+		!(prefix  != NULL && prefix->Token.Type  == TokenIdentifier::OP_INCREMENT && GetLocalVariable(prefix->LeftValue)  == index))
+	{
+		return false;
+	}
+
+	return IsLoopVariableModified(node->BodyStatement, array, index, IsArrayAliased(array)) == false;
 }
 
 // =================================================================
-//	Encloses an expression string with parenthesis if they are 
-//	required.
+//	Returns true if an array local may be referenced by anything
+//	other than itself. It is only known not to be if it was created
+//	by the local's own initializer and every use of it in the method
+//	indexes, slices or calls a method on it.
 // =================================================================
-std::string CCPPTranslator::Enclose(std::string val)
+bool CCPPTranslator::IsArrayAliased(CVariableStatementASTNode* array)
 {
-//	if (val[0] == '(' && val[val.size() - 1] == ')')
-//	{
-//		return val;
-//	}
+	if (array->IsParameter == true ||
+		array->AssignmentExpression == NULL)
+	{
+		return true;
+	}
+
+	CASTNode* value = array->AssignmentExpression;
+	while (dynamic_cast<CExpressionASTNode*>(value) != NULL)
+	{
+		value = dynamic_cast<CExpressionASTNode*>(value)->LeftValue;
+	}
+
+	CNewExpressionASTNode* newNode = dynamic_cast<CNewExpressionASTNode*>(value);
+	if ((newNode == NULL || newNode->IsArray == false) &&
+		dynamic_cast<CArrayInitializerASTNode*>(value) == NULL)
+	{
+		return true;
+	}
+
+	CASTNode* body = array->Parent;
+	while (body != NULL && dynamic_cast<CMethodBodyASTNode*>(body) == NULL)
+	{
+		body = body->Parent;
+	}
 
-	return "(" + val + ")";
+	return body == NULL || IsArrayReferenced(body, array) == true;
 }
 
 // =================================================================
-//	Returns true if the given string is a keyword. This is used to
-//	ignore trying to forward-declare classes that are keywords.
+//	Returns true if the given node references an array local in
+//	any way other than indexing, slicing or calling a method on it.
 // =================================================================
-bool CCPPTranslator::IsKeyword(std::string value)
+bool CCPPTranslator::IsArrayReferenced(CASTNode* node, CVariableStatementASTNode* array)
 {
-	if (value == "bool" ||
-		value == "int" ||
-		value == "float")
+	if (node == NULL)
+	{
+		return false;
+	}
+
+	CIdentifierExpressionASTNode* identifier = dynamic_cast<CIdentifierExpressionASTNode*>(node);
+	CIndexExpressionASTNode*	  index		 = dynamic_cast<CIndexExpressionASTNode*>(node);
+	CSliceExpressionASTNode*	  slice		 = dynamic_cast<CSliceExpressionASTNode*>(node);
+	CMethodCallExpressionASTNode* call		 = dynamic_cast<CMethodCallExpressionASTNode*>(node);
+
+	if (identifier != NULL && identifier->ExpressionResultVariable == array)
 	{
 		return true;
 	}
 
+	// The array itself is skipped when it is the value being
+	// indexed, sliced or called on.
+	CASTNode* skip = NULL;
+	if (index != NULL && GetLocalVariable(index->LeftValue) == array)
+	{
+		skip = index->LeftValue;
+	}
+	else if (slice != NULL && GetLocalVariable(slice->LeftValue) == array)
+	{
+		skip = slice->LeftValue;
+	}
+	else if (call != NULL && GetLocalVariable(call->LeftValue) == array)
+	{
+		skip = call->LeftValue;
+	}
+
+	for (std::vector<CASTNode*>::iterator iter = node->Children.begin(); iter != node->Children.end(); iter++)
+	{
+		if (*iter != skip && IsArrayReferenced(*iter, array) == true)
+		{
+			return true;
+		}
+	}
+
 	return false;
 }
 
 // =================================================================
-//	Emits all includes required for a class declaration.
+//	Returns true if the loop index or array may be modified by 
+//	the given node. Resizing an array replaces its buffer, so if 
+//	the array may be aliased any call that is not native, or any
+//	resize, could shrink it through another reference.
 // =================================================================
-void CCPPTranslator::EmitRequiredClassIncludes(CClassASTNode* node)
+bool CCPPTranslator::IsLoopVariableModified(CASTNode* node, CVariableStatementASTNode* array, CVariableStatementASTNode* index, bool aliased)
 {
-	if (node->SuperClass != NULL)
+	if (node == NULL)
 	{
-		if (node->SuperClass->IsNative == false)
-		{		
-			std::string path = node->SuperClass->MangledIdentifier;
-			EmitHeaderFile("#include \"%s.hpp\"\n", path.c_str());
+		return false;
+	}
+
+	CAssignmentExpressionASTNode* assignment = dynamic_cast<CAssignmentExpressionASTNode*>(node);
+	CPostFixExpressionASTNode*	  postfix	 = dynamic_cast<CPostFixExpressionASTNode*>(node);
+	CPreFixExpressionASTNode*	  prefix	 = dynamic_cast<CPreFixExpressionASTNode*>(node);
+	CMethodCallExpressionASTNode* call		 = dynamic_cast<CMethodCallExpressionASTNode*>(node);
+
+	if (assignment != NULL)
+	{
+		CVariableStatementASTNode* var = GetLocalVariable(assignment->LeftValue);
+		if (var == array || var == index)
+		{
+			return true;
+		}
+	}
+	else if (postfix != NULL)
+	{
+		if (GetLocalVariable(postfix->LeftValue) == index)
+		{
+			return true;
+		}
+	}
+	else if (prefix != NULL)
+	{
+		if ((prefix->Token.Type == TokenIdentifier::OP_INCREMENT || prefix->Token.Type == TokenIdentifier::OP_DECREMENT) &&
+			GetLocalVariable(prefix->LeftValue) == index)
+		{
+			return true;
+		}
+	}
+	else if (call != NULL)
+	{
+		CClassMemberASTNode* member = dynamic_cast<CClassMemberASTNode*>(call->ResolvedDeclaration);
+		if ((aliased == true || GetLocalVariable(call->LeftValue) == array) &&
+			(member == NULL || member->IsNative == false || member->Identifier == "Resize"))
+		{
+			return true;
 		}
 	}
 
-	for (std::vector<CClassASTNode*>::iterator  iter = node->Interfaces.begin(); iter != node->Interfaces.end(); iter++)
+	for (std::vector<CASTNode*>::iterator iter = node->Children.begin(); iter != node->Children.end(); iter++)
 	{
-		CClassASTNode* interfaceNode = *iter;
-		if (interfaceNode->IsNative == false)
-		{		
-			std::string path = interfaceNode->MangledIdentifier;
-			EmitHeaderFile("#include \"%s.hpp\"\n", path.c_str());
+		if (IsLoopVariableModified(*iter, array, index, aliased) == true)
+		{
+			return true;
 		}
 	}
 
-	EmitHeaderFile("\n");
+	return false;
 }
 
 // =================================================================
-//	Finds all class referenced by a given node and its children.
+//	Returns the class of the object that should be stored alongside
+//	the given local variable, or NULL if it lives on the heap.
 // =================================================================
-std::vector<CClassASTNode*> CCPPTranslator::FindReferencedClasses(CASTNode* node)
+CClassASTNode* CCPPTranslator::GetStackAllocatedClass(CVariableStatementASTNode* node)
 {
-	std::vector<CClassASTNode*> references;
-
-	// Class references?
-	CClassASTNode* classNode = dynamic_cast<CClassASTNode*>(node);
-	if (classNode != NULL)
+	CASTNode* value = node->AssignmentExpression;
+	while (value != NULL)
 	{
-		if (classNode->SuperClass != NULL)
+		CExpressionASTNode*		exprNode = dynamic_cast<CExpressionASTNode*>(value);
+		CCastExpressionASTNode* castNode = dynamic_cast<CCastExpressionASTNode*>(value);
+
+		if (exprNode != NULL)
+		{
+			value = exprNode->LeftValue;
+		}
+		else if (castNode != NULL && dynamic_cast<CObjectDataType*>(castNode->Type) != NULL)
 		{
-			CCollectionHelper::VectorAddIfNotExists(references, classNode->SuperClass);
+			value = castNode->RightValue;
 		}
-		for (std::vector<CClassASTNode*>::iterator  iter = classNode->Interfaces.begin(); iter != classNode->Interfaces.end(); iter++)
+		else
 		{
-			CCollectionHelper::VectorAddIfNotExists(references, *iter);
+			break;
 		}
 	}
 
-	// Expression result types.
-	CBaseExpressionASTNode* exprNode = dynamic_cast<CBaseExpressionASTNode*>(node);
-	if (exprNode != NULL)
+	CNewExpressionASTNode* newNode = dynamic_cast<CNewExpressionASTNode*>(value);
+	if (newNode != NULL && newNode->Allocation == AllocationType::Local)
 	{
-		CCollectionHelper::VectorAddIfNotExists(references, exprNode->ExpressionResultType->GetClass(NULL));
+		return newNode->DataType->GetClass(m_semanter);
 	}
 
-	// Grab references made by children.
-	for (std::vector<CASTNode*>::iterator  iter = node->Children.begin(); iter != node->Children.end(); iter++)
+	CMethodCallExpressionASTNode* callNode = dynamic_cast<CMethodCallExpressionASTNode*>(value);
+	if (callNode != NULL && callNode->StackAllocation != NULL)
+	{
+		return callNode->StackAllocation->DataType->GetClass(m_semanter);
+	}
+
+	return NULL;
+}
+
+// =================================================================
+//	Returns true if an index expression is inside a loop that has
+//	already proven it is in bounds.
+// =================================================================
+bool CCPPTranslator::IsIndexInBounds(CIndexExpressionASTNode* node)
+{
+	CVariableStatementASTNode* array = GetLocalVariable(node->LeftValue);
+	CVariableStatementASTNode* index = GetLocalVariable(node->IndexExpression);
+	if (array == NULL || index == NULL)
+	{
+		return false;
+	}
+
+	for (std::vector<std::pair<CVariableStatementASTNode*, CVariableStatementASTNode*> >::iterator iter = m_bounded_indexes.begin(); iter != m_bounded_indexes.end(); iter++)
 	{
-		std::vector<CClassASTNode*> child_refs = FindReferencedClasses(*iter);		
-		for (std::vector<CClassASTNode*>::iterator  ref_iter = child_refs.begin(); ref_iter != child_refs.end(); ref_iter++)
+		if (iter->first == array && iter->second == index)
 		{
-			CCollectionHelper::VectorAddIfNotExists(references, *ref_iter);	
+			return true;
 		}
 	}
 
-	return references;
+	return false;
 }
 
 // =================================================================
@@ -499,8 +1294,28 @@ void CCPPTranslator::GenerateEntryPoint(CPackageASTNode* node)
 	EmitSourceFile("int main(int argc, const char* argv[])\n");
 	EmitSourceFile("{\n");
 
-	// Call runtime initialization.
-	EmitSourceFile("lsRuntimeInit();\n");
+	// Call runtime initialization, passing the garbage collector settings.
+	CConfigState project_config		= m_context->GetCompiler()->GetProjectConfig();
+	int			 gc_markers			= CStringHelper::ToInt(project_config.GetString("GC_MARKERS", "0", false));
+	int			 gc_initial_heap	= CStringHelper::ToInt(project_config.GetString("GC_INITIAL_HEAP", "0", false));
+	int			 gc_divisor			= CStringHelper::ToInt(project_config.GetString("GC_FREE_SPACE_DIVISOR", "0", false));
+	std::string	 gc_incremental		= project_config.GetString("GC_INCREMENTAL", "On", false);
+
+	if (gc_incremental != "On" &&
+		gc_incremental != "Off")
+	{
+		m_context->FatalError(CStringHelper::FormatString("Unknown incremental collection mode '%s', expected On or Off.", gc_incremental.c_str()));
+	}
+
+	// The incremental collector can not use the layouts emitted for precise
+	// scanning, so precise scanning takes priority.
+	if (gc_incremental == "On" && m_precise_scanning == true)
+	{
+		m_context->Warning("GC_INCREMENTAL and GC_PRECISE_SCANNING are both on, incremental collection has been turned off so objects can be scanned precisely.");
+		gc_incremental = "Off";
+	}
+
+	EmitSourceFile("lsRuntimeInit(%i, %i, %i, %s);\n", gc_markers, gc_initial_heap, gc_divisor, gc_incremental == "On" ? "true" : "false");
 	EmitSourceFile("\n");
 
 	// Call class constructors.
@@ -508,6 +1323,7 @@ void CCPPTranslator::GenerateEntryPoint(CPackageASTNode* node)
 	{
 		CClassASTNode* classNode = dynamic_cast<CClassASTNode*>(*iter);
 		if (classNode != NULL &&
+			classNode->IsReachable == true &&
 			classNode->ClassConstructor != NULL)
 		{
 			if (classNode->ClassConstructor->IsExtension == true)
@@ -559,6 +1375,35 @@ void CCPPTranslator::TranslatePackage(CPackageASTNode* node)
 	m_source_package_directory	= m_dst_directory + "Packages/";
 	m_package					= node;
 	m_created_files.clear();
+	m_primitive_classes.clear();
+	AssignTypeIDs(node);
+
+	// Work out how array accesses should be bounds checked.
+	m_array_checks				= m_context->GetCompiler()->GetProjectConfig().GetString("TRANSLATOR_ARRAY_CHECKS", "Eliminate", false);
+	m_array_accesses			= 0;
+	m_unchecked_array_accesses	= 0;
+	m_bounded_indexes.clear();
+	m_stack_variables.clear();
+
+	// Work out which methods are small enough to inline.
+	m_inline_threshold			= CStringHelper::ToInt(m_context->GetCompiler()->GetProjectConfig().GetString("TRANSLATOR_INLINE_THRESHOLD", "0", false));
+	FindInlineMethods();
+
+	if (m_array_checks != "Off" &&
+		m_array_checks != "On" &&
+		m_array_checks != "Eliminate")
+	{
+		m_context->FatalError(CStringHelper::FormatString("Unknown array check mode '%s', expected Off, On or Eliminate.", m_array_checks.c_str()));
+	}
+
+	// Work out if the collector should be told where references are in objects.
+	std::string precise_scanning = m_context->GetCompiler()->GetProjectConfig().GetString("GC_PRECISE_SCANNING", "Off", false);
+	if (precise_scanning != "On" &&
+		precise_scanning != "Off")
+	{
+		m_context->FatalError(CStringHelper::FormatString("Unknown precise scanning mode '%s', expected On or Off.", precise_scanning.c_str()));
+	}
+	m_precise_scanning = (precise_scanning == "On");
 
 	// Make directories.
 	CPathHelper::MakeDirectory(m_dst_directory);
@@ -719,10 +1564,13 @@ void CCPPTranslator::TranslatePackage(CPackageASTNode* node)
 		{
 			for (unsigned int i = 0; i < child->GenericInstances.size(); i++)
 			{
-				TranslateClass(child->GenericInstances.at(i));
+				if (child->GenericInstances.at(i)->IsReachable == true)
+				{
+					TranslateClass(child->GenericInstances.at(i));
+				}
 			}
 		}
-		else
+		else if (child->IsReachable == true)
 		{
 			TranslateClass(child);
 		}
@@ -741,47 +1589,21 @@ void CCPPTranslator::TranslatePackage(CPackageASTNode* node)
 	}
 	EmitHeaderFile("\n");
 
-	// Emit all forward declarations.
-	std::vector<CASTNode*> referenced_classes = m_package->Children;//FindReferencedClasses(node);
-	for (std::vector<CASTNode*>::iterator iter = referenced_classes.begin(); iter != referenced_classes.end(); iter++)
-	{
-		CClassASTNode* child = dynamic_cast<CClassASTNode*>(*iter);
-		if (child == NULL)
-		{
-			continue;
-		}
-		if (child->IsGeneric == true)
-		{
-			for (std::vector<CClassASTNode*>::iterator iter2 = child->GenericInstances.begin(); iter2 != child->GenericInstances.end(); iter2++)
-			{
-				if (!IsKeyword((*iter2)->MangledIdentifier))
-				{
-					EmitHeaderFile("class %s;\n", (*iter2)->MangledIdentifier.c_str());
-				}
-
-				std::string path = (*iter2)->MangledIdentifier;
-				EmitSourceFile("#include \"%s.hpp\"\n", path.c_str());
-			}
-		}
-		else
-		{
-			if (!IsKeyword(child->MangledIdentifier))
-			{
-				EmitHeaderFile("class %s;\n", child->MangledIdentifier.c_str());
-			}
-
-			std::string path = child->MangledIdentifier;
-			EmitSourceFile("#include \"%s.hpp\"\n", path.c_str());
-		}
-	}
-	EmitHeaderFile("\n");
-	EmitSourceFile("\n");
+	// Emit all forward declarations, main needs every reachable class
+	// as it runs all the static constructors.
+	std::unordered_set<CClassASTNode*> all_classes;
+	EmitReferencedClasses(NULL, all_classes);
 
 	// Generate entry point.
 	GenerateEntryPoint(node);
 
 	CloseHeaderFile();
 	CloseSourceFile();
+
+	if (m_array_checks == "Eliminate")
+	{
+		m_context->Info(CStringHelper::FormatString("Removed bounds checks from %i of %i array accesses.", m_unchecked_array_accesses, m_array_accesses));
+	}
 }
 
 // =================================================================
@@ -789,10 +1611,19 @@ void CCPPTranslator::TranslatePackage(CPackageASTNode* node)
 // =================================================================
 void CCPPTranslator::TranslateClass(CClassASTNode* node)
 {
+	CProfiler*		profiler = m_context->GetCompiler()->GetProfiler();
+	CProfileScope	scope(profiler, "translate", profiler->IsEnabled() ? node->ToString() : "", node->Token.SourceFile);
+
 	// Open source file for this class.
 	OpenSourceFile(m_source_directory + node->MangledIdentifier);
 	OpenHeaderFile(m_source_directory + node->MangledIdentifier);
 
+	bool has_inline_file = (m_inline_classes.find(node) != m_inline_classes.end());
+	if (has_inline_file == true)
+	{
+		OpenInlineFile(m_source_directory + node->MangledIdentifier, node);
+	}
+
 	// Emit native include declarations.
 	for (unsigned int i = 0; i < m_native_file_paths.size(); i++)
 	{
@@ -806,42 +1637,10 @@ void CCPPTranslator::TranslateClass(CClassASTNode* node)
 	// Emit all translated includes we need.
 	EmitRequiredClassIncludes(node);
 	
-	// Emit all forward declarations.
-	std::vector<CASTNode*> referenced_classes = m_package->Children;//FindReferencedClasses(node);
-	for (std::vector<CASTNode*>::iterator iter = referenced_classes.begin(); iter != referenced_classes.end(); iter++)
-	{
-		CClassASTNode* child = dynamic_cast<CClassASTNode*>(*iter);
-		if (child == NULL || 
-			child == node)
-		{
-			continue;
-		}
-		if (child->IsGeneric == true)
-		{
-			for (std::vector<CClassASTNode*>::iterator iter2 = child->GenericInstances.begin(); iter2 != child->GenericInstances.end(); iter2++)
-			{
-				if (!IsKeyword((*iter2)->MangledIdentifier))
-				{
-					EmitHeaderFile("class %s;\n", (*iter2)->MangledIdentifier.c_str());
-				}
-
-				std::string path = (*iter2)->MangledIdentifier;
-				EmitSourceFile("#include \"%s.hpp\"\n", path.c_str());
-			}
-		}
-		else
-		{
-			if (!IsKeyword(child->MangledIdentifier))
-			{
-				EmitHeaderFile("class %s;\n", child->MangledIdentifier.c_str());
-			}
-				
-			std::string path = child->MangledIdentifier;
-			EmitSourceFile("#include \"%s.hpp\"\n", path.c_str());
-		}
-	}
-	EmitHeaderFile("\n");
-	EmitSourceFile("\n");
+	// Emit forward declarations and includes for the classes we reference.
+	std::unordered_set<CClassASTNode*> referenced_classes;
+	FindReferencedClasses(node, referenced_classes);
+	EmitReferencedClasses(node, referenced_classes);
 
 	// Native class? Abort abort.
 	if ((node->IsGeneric == false || node->GenericInstanceOf != NULL))
@@ -864,29 +1663,162 @@ void CCPPTranslator::TranslateClass(CClassASTNode* node)
 					{
 						inherit += ", ";
 					}
-					inherit += "public virtual " + inheritNode->MangledIdentifier;
+					if (std::find(node->VirtualInterfaces.begin(), node->VirtualInterfaces.end(), inheritNode) != node->VirtualInterfaces.end())
+					{
+						inherit += "public virtual " + inheritNode->MangledIdentifier;
+					}
+					else
+					{
+						inherit += "public " + inheritNode->MangledIdentifier;
+					}
 				}
 			}
 
+			// Classes that can't be extended are final so calls on them can be devirtualized. Abstract
+			// classes are left alone, the compiler would try and call their pure virtual methods directly.
+			std::string final_specifier = "";
+			if (node->IsInterface == false &&
+				node->IsAbstract == false &&
+				(node->IsSealed == true || node->IsExtended == false))
+			{
+				final_specifier = " final";
+			}
+
 			// Emit header class.
-			EmitHeaderFile("class %s%s\n", node->MangledIdentifier.c_str(), (inherit != "" ? " : " + inherit : "").c_str());	
+			EmitHeaderFile("class %s%s%s\n", node->MangledIdentifier.c_str(), final_specifier.c_str(), (inherit != "" ? " : " + inherit : "").c_str());	
 			EmitHeaderFile("{\npublic:\n");	
+
+			// Emit the range of type ids this class covers, and a constructor to
+			// tag instances with our id. These go in the source file so renumbering
+			// classes doesn't force everything including our header to rebuild.
+			std::unordered_map<CClassASTNode*, std::pair<int, int> >::iterator range = m_type_ranges.find(node);
+			if (range != m_type_ranges.end())
+			{
+				EmitHeaderFile("static const int lsTypeFirst;\n");
+				EmitHeaderFile("static const int lsTypeLast;\n");
+				EmitHeaderFile("%s();\n", node->MangledIdentifier.c_str());
+
+				EmitSourceFile("const int %s::lsTypeFirst = %i;\n", node->MangledIdentifier.c_str(), range->second.first);
+				EmitSourceFile("const int %s::lsTypeLast = %i;\n", node->MangledIdentifier.c_str(), range->second.second);
+				EmitSourceFile("%s::%s()\n", node->MangledIdentifier.c_str(), node->MangledIdentifier.c_str());
+				EmitSourceFile("{\n");
+				EmitSourceFile("lsTypeID = lsTypeFirst;\n");
+				EmitSourceFile("}\n");
+				EmitSourceFile("\n");
+			}
+
+			// Tell the collector where our references are.
+			if (m_precise_scanning == true && HasKnownLayout(node) == true)
+			{
+				EmitLayout(node);
+			}
+		}
+
+		for (std::vector<CASTNode*>::iterator iter = node->Body->Children.begin(); iter != node->Body->Children.end(); iter++)
+		{
+			CDeclarationASTNode* decl = dynamic_cast<CDeclarationASTNode*>(*iter);
+			if (decl != NULL && decl->IsReachable == false)
+			{
+				continue;
+			}
+			(*iter)->Translate(this);
+		}
+		
+		if (node->IsNative == false)
+		{
+			EmitHeaderFile("};\n");		
+			EmitHeaderFile("\n");	
+		}
+	}
+
+	if (has_inline_file == true)
+	{
+		CloseInlineFile();
+	}
+	CloseHeaderFile();
+	CloseSourceFile();
+}
+
+// =================================================================
+//	Returns true if every field of a class and its super classes 
+//	is declared by translated code, so we know which of them hold 
+//	references. Native classes other than object may hold references
+//	we know nothing about.
+// =================================================================
+bool CCPPTranslator::HasKnownLayout(CClassASTNode* node)
+{
+	if (node->IsInterface == true ||
+		node->IsStatic == true)
+	{
+		return false;
+	}
+
+	for (CClassASTNode* classNode = node; classNode != NULL; classNode = classNode->SuperClass)
+	{
+		if (classNode->IsNative == true)
+		{
+			return (classNode->Identifier == "object");
 		}
+	}
+
+	return true;
+}
+
+// =================================================================
+//	Emits the function that describes which fields of a class hold
+//	references, and an operator new that allocates instances with 
+//	that layout so the collector only scans those fields.
+// =================================================================
+void CCPPTranslator::EmitLayout(CClassASTNode* node)
+{
+	const char* identifier = node->MangledIdentifier.c_str();
+
+	EmitHeaderFile("static void lsDescribeLayout(lsGCLayout* layout);\n");
+	EmitHeaderFile("void* operator new(size_t size);\n");
+
+	EmitSourceFile("void %s::lsDescribeLayout(lsGCLayout* layout)\n", identifier);
+	EmitSourceFile("{\n");
+
+	if (node->SuperClass != NULL &&
+		node->SuperClass->IsNative == false)
+	{
+		EmitSourceFile("%s::lsDescribeLayout(layout);\n", node->SuperClass->MangledIdentifier.c_str());
+	}
 
-		for (std::vector<CASTNode*>::iterator iter = node->Body->Children.begin(); iter != node->Body->Children.end(); iter++)
+	for (std::vector<CASTNode*>::iterator iter = node->Body->Children.begin(); iter != node->Body->Children.end(); iter++)
+	{
+		CClassMemberASTNode* member = dynamic_cast<CClassMemberASTNode*>(*iter);
+		if (member == NULL ||
+			member->MemberType != MemberType::Field ||
+			member->IsStatic == true ||
+			member->IsExtension == true ||
+			member->IsReachable == false)
 		{
-			(*iter)->Translate(this);
+			continue;
 		}
-		
-		if (node->IsNative == false)
+
+		// Strings hold their characters outside the collected heap.
+		CDataType* type = member->ReturnType;
+		if (dynamic_cast<CBoolDataType*>(type)	 != NULL ||
+			dynamic_cast<CIntDataType*>(type)	 != NULL ||
+			dynamic_cast<CFloatDataType*>(type)	 != NULL ||
+			dynamic_cast<CStringDataType*>(type) != NULL)
 		{
-			EmitHeaderFile("};\n");		
-			EmitHeaderFile("\n");	
+			continue;
 		}
+
+		EmitSourceFile("layout->AddReference(offsetof(%s, %s));\n", identifier, member->MangledIdentifier.c_str());
 	}
 
-	CloseHeaderFile();
-	CloseSourceFile();
+	EmitSourceFile("}\n");
+	EmitSourceFile("\n");
+
+	EmitSourceFile("void* %s::operator new(size_t size)\n", identifier);
+	EmitSourceFile("{\n");
+	EmitSourceFile("static lsGCLayout layout(sizeof(%s), %s::lsDescribeLayout);\n", identifier, identifier);
+	EmitSourceFile("return lsGCObject::GCAllocateTyped(size, &layout);\n");
+	EmitSourceFile("}\n");
+	EmitSourceFile("\n");
 }
 
 // =================================================================
@@ -907,108 +1839,14 @@ void CCPPTranslator::TranslateClassMember(CClassMemberASTNode* node)
 			}
 		}
 
-		// Attributes
-		if (node->IsExtension == false)
-		{
-			if (node->IsStatic == true)
-			{
-				EmitHeaderFile("static ");
-			}
-			if (node->IsVirtual == true || classNode->IsInterface == true)
-			{
-				EmitHeaderFile("virtual ");
-			}
-		}
-
-		// Data type.
-		EmitHeaderFile("%s ", TranslateDataType(node->ReturnType).c_str());
-
-		// Identifier			
-		//if (node->IsExtension == false)
-		//{
-		//	EmitSourceFile(classNode->MangledIdentifier + "::");			
-		//}
-		EmitHeaderFile(node->MangledIdentifier);
-
-		// Arguments.
-		EmitHeaderFile("(");
-		if (node->IsExtension == true && node->IsStatic == false)
-		{
-			EmitHeaderFile(TranslateDataType(classNode->ObjectDataType) + " ext_this");
-			if (node->Arguments.size() > 0)
-			{
-				EmitHeaderFile(", ");
-			}
-		}
-		for (std::vector<CVariableStatementASTNode*>::iterator iter = node->Arguments.begin(); iter != node->Arguments.end(); iter++)
-		{
-			CVariableStatementASTNode* arg = *iter;
-			
-			EmitHeaderFile("%s ", TranslateDataType(arg->Type).c_str());
-			EmitHeaderFile(arg->MangledIdentifier);
-			
-			if (iter + 1 != node->Arguments.end())
-			{
-				EmitHeaderFile(", ");
-			}
-		}
-		EmitHeaderFile(")");
+		EmitMethod(node, classNode, false);
 
-		// Body
-		if (node->IsAbstract == true || classNode->IsInterface == true)
-		{
-			EmitHeaderFile(" = 0;");
-		}
-		else if (classNode->IsInterface == false && node->Body != NULL)
+		// Methods that return a new object the caller can store also 
+		// get a version that constructs it in storage the caller provides.
+		if (node->StackAllocation != NULL)
 		{
-			EmitHeaderFile(";");
-			
-			// Data type.
-			EmitSourceFile("%s ", TranslateDataType(node->ReturnType).c_str());
-			
-			// Class Identifier				
-			if (node->IsExtension == false)
-			{
-				EmitSourceFile(classNode->MangledIdentifier + "::");			
-			}
-			EmitSourceFile(node->MangledIdentifier);
-
-			// Arguments.
-			EmitSourceFile("(");
-			if (node->IsExtension == true && node->IsStatic == false)
-			{
-				EmitSourceFile(TranslateDataType(classNode->ObjectDataType) + " ext_this");
-				if (node->Arguments.size() > 0)
-				{
-					EmitSourceFile(", ");
-				}
-			}
-			for (std::vector<CVariableStatementASTNode*>::iterator iter = node->Arguments.begin(); iter != node->Arguments.end(); iter++)
-			{
-				CVariableStatementASTNode* arg = *iter;
-			
-				EmitSourceFile("%s ", TranslateDataType(arg->Type).c_str());
-				EmitSourceFile(arg->MangledIdentifier);
-			
-				if (iter + 1 != node->Arguments.end())
-				{
-					EmitSourceFile(", ");
-				}
-			}
-			EmitSourceFile(")\n");	
-			EmitSourceFile("{\n");	
-			//EmitGCCollect();
-			
-			// Translate body.
-			node->Body->TranslateChildren(this);
-			
-			//EmitGCCollect();
-			EmitSourceFile("}\n");
-			EmitSourceFile("\n");				
-		}		
-		else
-		{			
-			EmitHeaderFile(";");			
+			EmitHeaderFile("\n");
+			EmitMethod(node, classNode, true);
 		}
 	}
 
@@ -1070,6 +1908,164 @@ void CCPPTranslator::TranslateClassMember(CClassMemberASTNode* node)
 	EmitHeaderFile("\n");
 }
 
+// =================================================================
+//	Emits the declaration and body of a method. The stack variant
+//	takes an extra argument holding the storage that the object it
+//	returns should be constructed in.
+// =================================================================
+void CCPPTranslator::EmitMethod(CClassMemberASTNode* node, CClassASTNode* classNode, bool stack_variant)
+{
+	std::string identifier	= node->MangledIdentifier;
+	std::string storage_arg = "";
+	bool		is_inline	= (m_inline_methods.find(node) != m_inline_methods.end());
+
+	if (stack_variant == true)
+	{
+		identifier += "_Stack";
+		if (node->Arguments.size() > 0 || (node->IsExtension == true && node->IsStatic == false))
+		{
+			storage_arg = ", ";
+		}
+		storage_arg += node->StackAllocation->DataType->GetClass(m_semanter)->MangledIdentifier + "* lsStorage";
+	}
+
+	// Attributes
+	if (node->IsExtension == false)
+	{
+		if (node->IsStatic == true)
+		{
+			EmitHeaderFile("static ");
+		}
+		if (stack_variant == false &&
+			(classNode->IsInterface == true || 
+			 (node->IsVirtual == true && (node->IsAbstract == true || node->IsOverridden == true || node->HasBaseMember == true))))
+		{
+			EmitHeaderFile("virtual ");
+		}
+	}
+	if (is_inline == true)
+	{
+		EmitHeaderFile("inline ");
+	}
+
+	// Data type.
+	EmitHeaderFile("%s ", TranslateDataType(node->ReturnType).c_str());
+
+	// Identifier			
+	//if (node->IsExtension == false)
+	//{
+	//	EmitSourceFile(classNode->MangledIdentifier + "::");			
+	//}
+	EmitHeaderFile(identifier);
+
+	// Arguments.
+	EmitHeaderFile("(");
+	if (node->IsExtension == true && node->IsStatic == false)
+	{
+		EmitHeaderFile(TranslateDataType(classNode->ObjectDataType) + " ext_this");
+		if (node->Arguments.size() > 0)
+		{
+			EmitHeaderFile(", ");
+		}
+	}
+	for (std::vector<CVariableStatementASTNode*>::iterator iter = node->Arguments.begin(); iter != node->Arguments.end(); iter++)
+	{
+		CVariableStatementASTNode* arg = *iter;
+		
+		EmitHeaderFile("%s ", TranslateDataType(arg->Type).c_str());
+		EmitHeaderFile(arg->MangledIdentifier);
+		
+		if (iter + 1 != node->Arguments.end())
+		{
+			EmitHeaderFile(", ");
+		}
+	}
+	EmitHeaderFile(storage_arg);
+	EmitHeaderFile(")");
+
+	// Overrides that are never overridden themselves are final.
+	if (stack_variant == false &&
+		classNode->IsInterface == false &&
+		node->IsAbstract == false &&
+		node->IsOverridden == false &&
+		node->HasBaseMember == true)
+	{
+		EmitHeaderFile(" final");
+	}
+
+	// Body
+	if (node->IsAbstract == true || classNode->IsInterface == true)
+	{
+		EmitHeaderFile(" = 0;");
+	}
+	else if (classNode->IsInterface == false && node->Body != NULL)
+	{
+		EmitHeaderFile(";");
+
+		// Inlined methods are defined in the inline file instead.
+		if (is_inline == true)
+		{
+			m_source.Swap(m_inline);
+			EmitSourceFile("inline ");
+		}
+		
+		// Data type.
+		EmitSourceFile("%s ", TranslateDataType(node->ReturnType).c_str());
+		
+		// Class Identifier				
+		if (node->IsExtension == false)
+		{
+			EmitSourceFile(classNode->MangledIdentifier + "::");			
+		}
+		EmitSourceFile(identifier);
+
+		// Arguments.
+		EmitSourceFile("(");
+		if (node->IsExtension == true && node->IsStatic == false)
+		{
+			EmitSourceFile(TranslateDataType(classNode->ObjectDataType) + " ext_this");
+			if (node->Arguments.size() > 0)
+			{
+				EmitSourceFile(", ");
+			}
+		}
+		for (std::vector<CVariableStatementASTNode*>::iterator iter = node->Arguments.begin(); iter != node->Arguments.end(); iter++)
+		{
+			CVariableStatementASTNode* arg = *iter;
+		
+			EmitSourceFile("%s ", TranslateDataType(arg->Type).c_str());
+			EmitSourceFile(arg->MangledIdentifier);
+		
+			if (iter + 1 != node->Arguments.end())
+			{
+				EmitSourceFile(", ");
+			}
+		}
+		EmitSourceFile(storage_arg);
+		EmitSourceFile(")\n");	
+		EmitSourceFile("{\n");	
+		//EmitGCCollect();
+		
+		// Translate body.
+		m_stack_allocation = (stack_variant == true ? node->StackAllocation : NULL);
+		node->Body->TranslateChildren(this);
+		m_stack_allocation = NULL;
+		
+		//EmitGCCollect();
+		EmitSourceFile("}\n");
+		EmitSourceFile("\n");
+
+		if (is_inline == true)
+		{
+			m_source.Swap(m_inline);
+		}
+	}		
+	else
+	{			
+		EmitHeaderFile(";");			
+	}
+}
+
 // =================================================================
 //	Translate a data type.
 // =================================================================
@@ -1133,6 +2129,19 @@ void CCPPTranslator::TranslateVariableStatement(CVariableStatementASTNode* node)
 {
 	CClassASTNode* classNode = dynamic_cast<CClassASTNode*>(node->Parent->Parent);
 	
+	// Objects that never escape are stored alongside the variable.
+	CClassASTNode* stackClass = GetStackAllocatedClass(node);
+	if (stackClass != NULL)
+	{
+		m_stack_storage = NewInternalVariableName();
+		EmitSourceFile("%s %s;\n", stackClass->MangledIdentifier.c_str(), m_stack_storage.c_str());
+
+		if (node->StackClass == stackClass)
+		{
+			m_stack_variables.insert(std::pair<CVariableStatementASTNode*, std::string>(node, m_stack_storage));
+		}
+	}
+
 	// Data type.
 	EmitSourceFile("%s ", TranslateDataType(node->Type).c_str());
 
@@ -1144,6 +2153,7 @@ void CCPPTranslator::TranslateVariableStatement(CVariableStatementASTNode* node)
 	{
 		EmitSourceFile(" = %s", dynamic_cast<CExpressionBaseASTNode*>(node->AssignmentExpression)->TranslateExpr(this).c_str());
 	}
+	m_stack_storage = "";
 
 	// Semicolon!
 	EmitSourceFile(";\n");
@@ -1317,9 +2327,25 @@ void CCPPTranslator::TranslateForStatement(CForStatementASTNode* node)
 		EmitSourceFile(")\n");
 	}
 
+	// Accesses to the array using the loop index don't need to be
+	// checked if we can prove the index is always in bounds.
+	CVariableStatementASTNode* array = NULL;
+	CVariableStatementASTNode* index = NULL;
+	bool					   bounded = (m_array_checks == "Eliminate" && IsBoundedIndexLoop(node, array, index));
+
+	if (bounded == true)
+	{
+		m_bounded_indexes.push_back(std::pair<CVariableStatementASTNode*, CVariableStatementASTNode*>(array, index));
+	}
+
 	EmitSourceFile("{\n");
 	node->BodyStatement->Translate(this);
 	EmitSourceFile("}\n");
+
+	if (bounded == true)
+	{
+		m_bounded_indexes.pop_back();
+	}
 }
 
 // =================================================================
@@ -1644,6 +2670,16 @@ std::string	CCPPTranslator::TranslateComparisonExpression(CComparisonExpressionA
 	CExpressionBaseASTNode* left_base  = dynamic_cast<CExpressionBaseASTNode*>(node->LeftValue);
 	CExpressionBaseASTNode* right_base = dynamic_cast<CExpressionBaseASTNode*>(node->RightValue);
 
+	// Comparing single characters of strings compares their values 
+	// rather than constructing strings to hold them.
+	if ((node->Token.Type == TokenIdentifier::OP_EQUAL || node->Token.Type == TokenIdentifier::OP_NOT_EQUAL) &&
+		(IsCharacterAccess(left_base) == true || IsCharacterAccess(right_base) == true) &&
+		(IsCharacterAccess(left_base) == true || IsCharacterLiteral(left_base) == true) &&
+		(IsCharacterAccess(right_base) == true || IsCharacterLiteral(right_base) == true))
+	{
+		return Enclose(TranslateCharacter(left_base) + (node->Token.Type == TokenIdentifier::OP_EQUAL ? " == " : " != ") + TranslateCharacter(right_base));
+	}
+
 	switch (node->Token.Type)
 	{			
 		case TokenIdentifier::OP_EQUAL:			return Enclose(left_base->TranslateExpr(this) + " == " + right_base->TranslateExpr(this));
@@ -1717,6 +2753,35 @@ std::string	CCPPTranslator::TranslateIndexExpression(CIndexExpressionASTNode* no
 		op = "->";
 	}
 
+	// Access the array buffer directly if bounds checks are disabled or
+	// we know the index is in bounds.
+	if (dynamic_cast<CArrayDataType*>(left_base->ExpressionResultType) != NULL)
+	{
+		m_array_accesses++;
+
+		if (m_array_checks == "Off" ||
+			(m_array_checks == "Eliminate" && IsIndexInBounds(node)))
+		{
+			m_unchecked_array_accesses++;
+
+			std::string element = left_base->TranslateExpr(this) + op + "GetBuffer()[" + index_base->TranslateExpr(this) + "]";
+			if (set == false)
+			{
+				return element;
+			}
+			else if (postfix == true)
+			{
+				return "lsSetPostfix(" + element + ", " + set_expr + ")";
+			}
+			else
+			{
+				// Stored through the array so it can tell if its storage
+				// needs finalizing.
+				return left_base->TranslateExpr(this) + op + "SetIndexUnchecked(" + index_base->TranslateExpr(this) + ", " + set_expr + ")";
+			}
+		}
+	}
+
 	if (set == true)
 	{
 		//if (dynamic_cast<CObjectDataType*>(node->ExpressionResultType) != NULL)
@@ -1737,6 +2802,79 @@ std::string	CCPPTranslator::TranslateIndexExpression(CIndexExpressionASTNode* no
 	}
 }
 
+// =================================================================
+//	Checks if an expression reads a single character out of a 
+//	string, either by indexing it or by calling GetIndex.
+// =================================================================
+bool CCPPTranslator::IsCharacterAccess(CASTNode* node)
+{
+	CIndexExpressionASTNode* index = dynamic_cast<CIndexExpressionASTNode*>(node);
+	if (index != NULL)
+	{
+		CExpressionBaseASTNode* left_base = dynamic_cast<CExpressionBaseASTNode*>(index->LeftValue);
+		return (dynamic_cast<CStringDataType*>(left_base->ExpressionResultType) != NULL);
+	}
+
+	CMethodCallExpressionASTNode* call = dynamic_cast<CMethodCallExpressionASTNode*>(node);
+	if (call != NULL)
+	{
+		CExpressionBaseASTNode* left_base = dynamic_cast<CExpressionBaseASTNode*>(call->LeftValue);
+		CClassMemberASTNode*	member	  = dynamic_cast<CClassMemberASTNode*>(call->ResolvedDeclaration);
+		return (member != NULL &&
+				member->IsExtension == false &&
+				member->Identifier == "GetIndex" &&
+				call->ArgumentExpressions.size() == 1 &&
+				dynamic_cast<CStringDataType*>(left_base->ExpressionResultType) != NULL);
+	}
+
+	return false;
+}
+
+// =================================================================
+//	Checks if an expression is a string literal holding a single
+//	character. Null characters are excluded as the literal they
+//	translate to is an empty string.
+// =================================================================
+bool CCPPTranslator::IsCharacterLiteral(CASTNode* node)
+{
+	CLiteralExpressionASTNode* literal = dynamic_cast<CLiteralExpressionASTNode*>(node);
+	return (literal != NULL &&
+			dynamic_cast<CStringDataType*>(literal->ExpressionResultType) != NULL &&
+			literal->Literal.size() == 1 &&
+			literal->Literal[0] != '\0');
+}
+
+// =================================================================
+//	Translates a character access or character literal into an 
+//	expression giving the characters value, the same value ToChar 
+//	would give, without constructing a string to hold it.
+// =================================================================
+std::string CCPPTranslator::TranslateCharacter(CASTNode* node)
+{
+	if (IsCharacterLiteral(node) == true)
+	{
+		return CStringHelper::ToString((int)dynamic_cast<CLiteralExpressionASTNode*>(node)->Literal[0]);
+	}
+
+	CExpressionBaseASTNode* left_base  = NULL;
+	CExpressionBaseASTNode* index_base = NULL;
+
+	CIndexExpressionASTNode* index = dynamic_cast<CIndexExpressionASTNode*>(node);
+	if (index != NULL)
+	{
+		left_base  = dynamic_cast<CExpressionBaseASTNode*>(index->LeftValue);
+		index_base = dynamic_cast<CExpressionBaseASTNode*>(index->IndexExpression);
+	}
+	else
+	{
+		CMethodCallExpressionASTNode* call = dynamic_cast<CMethodCallExpressionASTNode*>(node);
+		left_base  = dynamic_cast<CExpressionBaseASTNode*>(call->LeftValue);
+		index_base = dynamic_cast<CExpressionBaseASTNode*>(call->ArgumentExpressions.at(0));
+	}
+
+	return left_base->TranslateExpr(this) + ".CharAt(" + index_base->TranslateExpr(this) + ")";
+}
+
 // =================================================================
 //	Translates a literal expression.
 // =================================================================
@@ -1958,10 +3096,22 @@ std::string	CCPPTranslator::TranslateMethodCallExpression(CMethodCallExpressionA
 {
 	CExpressionBaseASTNode* left_base  = dynamic_cast<CExpressionBaseASTNode*>(node->LeftValue);
 
-	std::string args = "";
+	CScratchScope scratch(this);
+	std::string& args = scratch.Text;
 
 	CClassMemberASTNode* member = dynamic_cast<CClassMemberASTNode*>(node->ResolvedDeclaration);
 
+	// Reading the value of a single character does not need a string 
+	// constructing to hold it.
+	if (member != NULL &&
+		member->IsExtension == false &&
+		member->Identifier == "ToChar" &&
+		node->ArgumentExpressions.size() == 0 &&
+		(IsCharacterAccess(left_base) == true || IsCharacterLiteral(left_base) == true))
+	{
+		return TranslateCharacter(left_base);
+	}
+
 	if (member != NULL && member->IsExtension == true && member->IsStatic == false)
 	{
 		args += left_base->TranslateExpr(this);
@@ -1975,15 +3125,40 @@ std::string	CCPPTranslator::TranslateMethodCallExpression(CMethodCallExpressionA
 		}
 		
 		CExpressionBaseASTNode* arg  = dynamic_cast<CExpressionBaseASTNode*>(*iter);
-		args += Enclose(arg->TranslateExpr(this));
+		args += '(';
+		args += arg->TranslateExpr(this);
+		args += ')';
 	}
 
 	CClassASTNode* left_class = left_base->ExpressionResultType->GetClass(m_semanter);
+	std::string	   identifier = node->ResolvedDeclaration->MangledIdentifier;
+
+	// Pass in the storage the returned object should be constructed in.
+	bool stack_allocated = false;
+	if (node->StackAllocation != NULL &&
+		(node->Allocation == AllocationType::Temporary || m_stack_storage != ""))
+	{
+		if (args != "")
+		{
+			args += ", ";
+		}
+		if (node->Allocation == AllocationType::Temporary)
+		{
+			args += "lsStackTemporary(" + node->StackAllocation->DataType->GetClass(m_semanter)->MangledIdentifier + "())";
+		}
+		else
+		{
+			args += "&" + m_stack_storage;
+		}
+
+		identifier += "_Stack";
+		stack_allocated = true;
+	}
 	
 	// Extension method.
 	if (member != NULL && member->IsExtension == true)
 	{
-		return node->ResolvedDeclaration->MangledIdentifier  + "(" + args + ")";
+		return identifier + "(" + args + ")";
 	}
 
 	// Class access.
@@ -1993,19 +3168,52 @@ std::string	CCPPTranslator::TranslateMethodCallExpression(CMethodCallExpressionA
 		dynamic_cast<CBoolDataType*>(left_base->ExpressionResultType)			!= NULL ||
 		dynamic_cast<CClassReferenceDataType*>(left_base->ExpressionResultType) != NULL)
 	{
-		return left_base->TranslateExpr(this) + "::" + node->ResolvedDeclaration->MangledIdentifier  + "(" + args + ")";
+		return left_base->TranslateExpr(this) + "::" + identifier + "(" + args + ")";
 	}
 
 	// Value access.
 	else if (dynamic_cast<CStringDataType*>(left_base->ExpressionResultType))
 	{
-		return left_base->TranslateExpr(this) + "." + node->ResolvedDeclaration->MangledIdentifier  + "(" + args + ")";
+		return left_base->TranslateExpr(this) + "." + identifier + "(" + args + ")";
 	}
 
 	// Pointer access.
 	else if (dynamic_cast<CObjectDataType*>(left_base->ExpressionResultType))
 	{
-		return left_base->TranslateExpr(this) + "->" + node->ResolvedDeclaration->MangledIdentifier  + "(" + args + ")";
+		CClassASTNode* target_class = node->ResolvedTarget == NULL ? NULL : dynamic_cast<CClassASTNode*>(node->ResolvedTarget->Parent->Parent);
+
+		// Objects stored alongside a local are called directly through it.
+		CIdentifierExpressionASTNode* left_ident = dynamic_cast<CIdentifierExpressionASTNode*>(left_base);
+		if (target_class != NULL && left_ident != NULL)
+		{
+			std::unordered_map<CVariableStatementASTNode*, std::string>::iterator iter = m_stack_variables.find(dynamic_cast<CVariableStatementASTNode*>(left_ident->ResolvedDeclaration));
+			if (iter != m_stack_variables.end())
+			{
+				return iter->second + "." + target_class->MangledIdentifier + "::" + identifier + "(" + args + ")";
+			}
+		}
+
+		// Methods that construct their result in our storage are never virtual.
+		if (stack_allocated == true)
+		{
+			return left_base->TranslateExpr(this) + "->" + target_class->MangledIdentifier + "::" + identifier + "(" + args + ")";
+		}
+
+		// If we know exactly which method will be invoked, call it directly rather 
+		// than going through the vtable.
+		CClassASTNode* member_class = member == NULL ? NULL : dynamic_cast<CClassASTNode*>(member->Parent->Parent);
+		if (member_class != NULL &&
+			member_class->IsInterface == false &&
+			member_class->IsNative == false &&
+			member->IsAbstract == false &&
+			member->IsStatic == false &&
+			(member->IsOverridden == true || member->HasBaseMember == true) &&
+			(member->IsOverridden == false || left_class->IsSealed == true || left_class->IsExtended == false))
+		{
+			return left_base->TranslateExpr(this) + "->" + member_class->MangledIdentifier + "::" + identifier + "(" + args + ")";
+		}
+
+		return left_base->TranslateExpr(this) + "->" + identifier + "(" + args + ")";
 	}
 
 	// Wut
@@ -2083,7 +3291,7 @@ std::string	CCPPTranslator::TranslateCastExpression(CCastExpressionASTNode* node
 		if (fromType->GetClass(m_semanter)->IsInterface == true &&
 			toType->GetClass(m_semanter)->IsInterface == false)
 		{
-			return "lsCast<" + TranslateDataType(toType) + ">(" + Enclose(exprTrans) + ", " + (node->ExceptionOnFail ? "true" : "false") + ")";
+			return TranslateClassCast(fromType, toType, exprTrans, node->ExceptionOnFail);
 		}
 
 		// Upcasting (make sure we are not an array, arrays are special cases).
@@ -2097,7 +3305,7 @@ std::string	CCPPTranslator::TranslateCastExpression(CCastExpressionASTNode* node
 		// Downcasting
 		else
 		{
-			return "lsCast<" + TranslateDataType(toType) + ">(" + Enclose(exprTrans) + ", " + (node->ExceptionOnFail ? "true" : "false") + ")";
+			return TranslateClassCast(fromType, toType, exprTrans, node->ExceptionOnFail);
 		}
 	}
 
@@ -2150,8 +3358,31 @@ std::string	CCPPTranslator::TranslateNewExpression(CNewExpressionASTNode* node)
 	}
 	else
 	{
+		std::string classIdentifier = node->DataType->GetClass(m_semanter)->MangledIdentifier;
+
+		// Construct it in storage provided by our caller.
+		if (node == m_stack_allocation)
+		{
+			result += "lsStorage";
+		}
+
+		// Construct it in storage declared alongside the variable it initializes.
+		else if (node->Allocation == AllocationType::Local && m_stack_storage != "")
+		{
+			result += "(&" + m_stack_storage + ")";
+		}
+
+		// Construct it in a temporary that lives until the end of the expression.
+		else if (node->Allocation == AllocationType::Temporary)
+		{
+			result += "lsStackTemporary(" + classIdentifier + "())";
+		}
+
 		// Create a new object.
-		result += "(new " + node->DataType->GetClass(m_semanter)->MangledIdentifier + "())";
+		else
+		{
+			result += "(new " + classIdentifier + "())";
+		}
 
 		// Invoke the constructor.
 		result += "->" + node->ResolvedConstructor->MangledIdentifier + "(";
@@ -2204,7 +3435,7 @@ std::string	CCPPTranslator::TranslateTypeExpression(CTypeExpressionASTNode* node
 				if (fromType->GetClass(m_semanter)->IsInterface == true &&
 					toType->GetClass(m_semanter)->IsInterface == false)
 				{
-					return Enclose("lsCast<" + TranslateDataType(toType) + ">(" + exprTrans + ", false) != 0");
+					return Enclose(TranslateClassCast(fromType, toType, exprTrans, false) + " != 0");
 				}
 
 				// Upcasting
@@ -2216,7 +3447,7 @@ std::string	CCPPTranslator::TranslateTypeExpression(CTypeExpressionASTNode* node
 				// Downcasting
 				else
 				{
-					return Enclose("lsCast<" + TranslateDataType(toType) + ">(" + exprTrans + ", false) != 0");
+					return Enclose(TranslateClassCast(fromType, toType, exprTrans, false) + " != 0");
 				}
 			}
 		case TokenIdentifier::KEYWORD_AS:
@@ -9,8 +9,14 @@
 #ifndef _CCPPTRANSLATOR_H_
 #define _CCPPTRANSLATOR_H_
 
+#include <map>
+#include <deque>
+#include <unordered_set>
+#include <unordered_map>
+
 #include "CToken.h"
 #include "CTranslator.h"
+#include "COutputBuffer.h"
 
 class CASTNode;
 class CTranslationUnit;
@@ -59,17 +65,35 @@ private:
 
 	CPackageASTNode* m_package;
 
+	std::map<std::string, CClassASTNode*> m_primitive_classes;
+
+	std::unordered_map<CClassASTNode*, std::pair<int, int> > m_type_ranges;
+
+	bool m_precise_scanning;
+
+	std::string m_array_checks;
+	std::vector<std::pair<CVariableStatementASTNode*, CVariableStatementASTNode*> > m_bounded_indexes;
+	int m_array_accesses;
+	int m_unchecked_array_accesses;
+
+	CNewExpressionASTNode* m_stack_allocation;
+	std::string m_stack_storage;
+	std::unordered_map<CVariableStatementASTNode*, std::string> m_stack_variables;
+
+	int m_inline_threshold;
+	std::unordered_set<CClassMemberASTNode*> m_inline_methods;
+	std::unordered_set<CClassASTNode*> m_inline_classes;
+	std::string m_inline_file_path;
+	COutputBuffer m_inline;
+
 	std::string m_header_file_path;
 	std::string m_source_file_path;
 
-	int m_header_indent_level;
-	int m_source_indent_level;
-
-	bool m_last_source_was_newline;
-	bool m_last_header_was_newline;
+	COutputBuffer m_source;
+	COutputBuffer m_header;
 
-	std::string m_source_source;
-	std::string m_header_source;
+	std::deque<std::string> m_scratch;
+	int m_scratch_depth;
 
 	std::string m_include_guard;
 
@@ -91,24 +115,59 @@ public:
 	void OpenHeaderFile								(std::string format);
 	void CloseSourceFile							();
 	void CloseHeaderFile							();
+	void OpenInlineFile								(std::string format, CClassASTNode* node);
+	void CloseInlineFile							();
 
 	void GenerateEntryPoint							(CPackageASTNode* node);
 
-	void EmitSourceFile								(std::string text, ...);
-	void EmitHeaderFile								(std::string text, ...);
+	void EmitSourceFile								(const char* text, ...);
+	void EmitSourceFile								(const std::string& text);
+	void EmitHeaderFile								(const char* text, ...);
+	void EmitHeaderFile								(const std::string& text);
+
+	std::string& AcquireScratch						();
+	void		 ReleaseScratch						();
 
 	void EmitGCCollect								();
 	
 	std::string NewInternalVariableName				();
 	std::string EscapeCString						(std::string val);
-	std::string Enclose								(std::string val);
+	std::string Enclose								(const std::string& val);
 
 	bool		IsKeyword							(std::string value);
 
 	std::string FindIncludePath						(std::string path);
 	void		EmitRequiredClassIncludes			(CClassASTNode* node);
 
-	std::vector<CClassASTNode*> FindReferencedClasses(CASTNode* node);
+	void		FindReferencedClasses				(CASTNode* node, std::unordered_set<CClassASTNode*>& references);
+	void		AddReferencedDataType				(CDataType* type, std::unordered_set<CClassASTNode*>& references);
+	void		EmitReferencedClasses				(CClassASTNode* node, std::unordered_set<CClassASTNode*>& references);
+	void		GetTranslatedClasses				(std::vector<CClassASTNode*>& classes);
+
+	void		FindInlineMethods					();
+	bool		CountInlineCost						(CASTNode* node, CClassMemberASTNode* method, int& cost);
+	void		AddInlineClasses					(CClassASTNode* node, std::unordered_set<CClassASTNode*>& classes);
+
+	void		AssignTypeIDs						(CPackageASTNode* node);
+	int			AssignTypeID						(CClassASTNode* node, int next_id, std::unordered_map<CClassASTNode*, std::vector<CClassASTNode*> >& subclasses);
+	std::string	TranslateClassCast					(CDataType* fromType, CDataType* toType, std::string expr, bool exception_on_fail);
+
+	bool		HasKnownLayout						(CClassASTNode* node);
+	void		EmitLayout							(CClassASTNode* node);
+
+	CVariableStatementASTNode* GetLocalVariable		(CASTNode* node);
+	bool		IsBoundedIndexLoop					(CForStatementASTNode* node, CVariableStatementASTNode*& array, CVariableStatementASTNode*& index);
+	bool		IsLoopVariableModified				(CASTNode* node, CVariableStatementASTNode* array, CVariableStatementASTNode* index, bool aliased);
+	bool		IsArrayAliased						(CVariableStatementASTNode* array);
+	bool		IsArrayReferenced					(CASTNode* node, CVariableStatementASTNode* array);
+	bool		IsIndexInBounds						(CIndexExpressionASTNode* node);
+
+	bool		IsCharacterAccess					(CASTNode* node);
+	bool		IsCharacterLiteral					(CASTNode* node);
+	std::string	TranslateCharacter					(CASTNode* node);
+
+	CClassASTNode* GetStackAllocatedClass			(CVariableStatementASTNode* node);
+	void		EmitMethod							(CClassMemberASTNode* node, CClassASTNode* classNode, bool stack_variant);
 
 	virtual std::string TranslateDataType			(CDataType* dt);
 
@@ -155,5 +214,31 @@ public:
 
 };
 
+// =================================================================
+//	Borrows one of the translators scratch strings for the lifetime
+//	of a scope. Expressions are built up in these so the memory is
+//	reused rather than allocated for every expression translated.
+// =================================================================
+class CScratchScope
+{
+private:
+	CCPPTranslator* m_translator;
+
+public:
+	std::string& Text;
+
+	CScratchScope(CCPPTranslator* translator) :
+		m_translator(translator),
+		Text(translator->AcquireScratch())
+	{
+	}
+
+	~CScratchScope()
+	{
+		m_translator->ReleaseScratch();
+	}
+
+};
+
 #endif
 
@@ -199,6 +199,40 @@ CASTNode* CCastExpressionASTNode::Semant(CSemanter* semanter)
 		}
 	}
 
+	// Fold constant casts between primitive types. Only int is converted
+	// to a string, as the runtime formats floats and bools differently.
+	if (semanter->IsConstant(RightValue))
+	{
+		bool fromNumeric = dynamic_cast<CBoolDataType*>(rightValueDataType)  != NULL ||
+						   dynamic_cast<CIntDataType*>(rightValueDataType)   != NULL ||
+						   dynamic_cast<CFloatDataType*>(rightValueDataType) != NULL;
+		bool toNumeric	 = dynamic_cast<CBoolDataType*>(ExpressionResultType)  != NULL ||
+						   dynamic_cast<CIntDataType*>(ExpressionResultType)   != NULL ||
+						   dynamic_cast<CFloatDataType*>(ExpressionResultType) != NULL;
+
+		if (fromNumeric == true && toNumeric == true)
+		{
+			if (dynamic_cast<CFloatDataType*>(rightValueDataType) != NULL &&
+				dynamic_cast<CIntDataType*>(ExpressionResultType) != NULL)
+			{
+				float value = RightValue->Evaluate(semanter->GetContext()).GetFloat();
+				if (value > -2147483648.0f && value < 2147483648.0f)
+				{
+					return semanter->FoldConstant(this);
+				}
+			}
+			else
+			{
+				return semanter->FoldConstant(this);
+			}
+		}
+		else if (dynamic_cast<CIntDataType*>(rightValueDataType) != NULL &&
+				 dynamic_cast<CStringDataType*>(ExpressionResultType) != NULL)
+		{
+			return semanter->FoldConstant(this);
+		}
+	}
+
 	return this;
 }
 
@@ -30,6 +30,8 @@
 #include "CCastExpressionASTNode.h"
 
 #include "CTranslator.h"
+#include "CCompiler.h"
+#include "CProfiler.h"
 
 // =================================================================
 //	Constructs a new instance of this class.
@@ -58,6 +60,7 @@ CClassASTNode::CClassASTNode(CASTNode* parent, CToken token) :
 	HasBoxClass				= false;
 	BoxClassIdentifier		= "";
 	IsEnum					= false;
+	IsExtended				= true;
 }
 
 // =================================================================
@@ -65,13 +68,9 @@ CClassASTNode::CClassASTNode(CASTNode* parent, CToken token) :
 // =================================================================
 CClassASTNode::~CClassASTNode()
 {
-	for (std::vector<CClassASTNode*>::iterator iter = GenericInstances.begin(); iter != GenericInstances.end(); iter++)
-	{
-		delete (*iter);
-	}
+	// Generic instances and our data type belong to the arena.
 	GenericInstances.clear();
-	
-	delete ObjectDataType;
+	ObjectDataType = NULL;
 }
 
 // =================================================================
@@ -187,6 +186,9 @@ CASTNode* CClassASTNode::Semant(CSemanter* semanter)
 		return this;
 	}
 	Semanted = true;
+
+	CProfiler*		profiler = semanter->GetContext()->GetCompiler()->GetProfiler();
+	CProfileScope	scope(profiler, "semant", profiler->IsEnabled() ? ToString() : "", Token.SourceFile);
 	
 	// Check for duplicate identifiers (only if we are not an instanced class).
 	if (GenericInstanceOf == NULL)
@@ -353,7 +355,8 @@ CASTNode* CClassASTNode::Semant(CSemanter* semanter)
 			}
 
 			// If no argument-less constructor has been provided, lets create a default one.
-			if (IsStatic == false && IsAbstract == false && IsInterface == false && IsNative == false && IsEnum == false)
+			// Abstract classes need one too, as their subclasses' constructors call it.
+			if (IsStatic == false && IsInterface == false && IsNative == false && IsEnum == false)
 			{
 				CClassMemberASTNode* defaultCtor = FindClassMethod(semanter, Identifier, std::vector<CDataType*>(), false);
 				if (defaultCtor == NULL)
@@ -383,6 +386,9 @@ CASTNode* CClassASTNode::Semant(CSemanter* semanter)
 // =================================================================
 CASTNode* CClassASTNode::Finalize(CSemanter* semanter)
 {
+	CProfiler*		profiler = semanter->GetContext()->GetCompiler()->GetProfiler();
+	CProfileScope	scope(profiler, "finalize", profiler->IsEnabled() ? ToString() : "", Token.SourceFile);
+
 	// If we are generic, only finalize instances.
 	if (IsGeneric == false || GenericInstanceOf != NULL)
 	{
@@ -701,6 +707,14 @@ CClassMemberASTNode* CClassASTNode::FindClassMethod(CSemanter*					semanter,
 		return NULL;
 	}
 
+	// If this is a generic instance method no one has called yet then 
+	// its time to semant it. Lookups that ignore a node are just 
+	// checking for duplicates and overrides so don't count.
+	if (match->IsBodyDeferred == true && ignoreNode == NULL)
+	{
+		match->SemantBody(semanter);
+	}
+
 	// Return matched class.
 	return match;
 }
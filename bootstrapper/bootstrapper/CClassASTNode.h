@@ -66,6 +66,10 @@ public:
 	
 	CClassASTNode*						SuperClass;
 	std::vector<CClassASTNode*>			Interfaces;	
+
+	// Class hierarchy infered data.
+	bool								IsExtended;
+	std::vector<CClassASTNode*>			VirtualInterfaces;
 	
 	// General management.
 	virtual std::string ToString();
@@ -0,0 +1,241 @@
+/* *****************************************************************
+
+		CClassHierarchy.cpp
+
+		Copyright (C) 2012 Tim Leonard - All Rights Reserved
+
+   ***************************************************************** */
+
+#include <string>
+#include <stdio.h>
+#include <algorithm>
+
+#include "CCompiler.h"
+#include "CClassHierarchy.h"
+#include "CStringHelper.h"
+#include "CProfiler.h"
+#include "CTranslationUnit.h"
+
+#include "CASTNode.h"
+#include "CClassASTNode.h"
+#include "CClassBodyASTNode.h"
+#include "CClassMemberASTNode.h"
+
+// =================================================================
+//	Analyses the hierarchy of every class that is going to be
+//	translated.
+// =================================================================
+bool CClassHierarchy::Process(CTranslationUnit* context)
+{
+	CProfileScope scope(context->GetCompiler()->GetProfiler(), "hierarchy", "", context->GetFilePath());
+
+	m_classes.clear();
+	m_methods.clear();
+
+	// Find every class that will be translated.
+	std::vector<CASTNode*>& children = context->GetASTRoot()->Children;
+	for (std::vector<CASTNode*>::iterator iter = children.begin(); iter != children.end(); iter++)
+	{
+		CClassASTNode* classNode = dynamic_cast<CClassASTNode*>(*iter);
+		if (classNode == NULL)
+		{
+			continue;
+		}
+		if (classNode->IsGeneric == true)
+		{
+			for (std::vector<CClassASTNode*>::iterator iter2 = classNode->GenericInstances.begin(); iter2 != classNode->GenericInstances.end(); iter2++)
+			{
+				CollectClass(*iter2);
+			}
+		}
+		else
+		{
+			CollectClass(classNode);
+		}
+	}
+
+	// Work out which classes have been extended.
+	for (std::vector<CClassASTNode*>::iterator iter = m_classes.begin(); iter != m_classes.end(); iter++)
+	{
+		CClassASTNode* classNode = *iter;
+		if (classNode->SuperClass != NULL)
+		{
+			classNode->SuperClass->IsExtended = true;
+		}
+	}
+
+	// Overriding methods share the mangled identifier of the method they
+	// override, so look for it further up the hierarchy.
+	for (std::vector<CClassASTNode*>::iterator iter = m_classes.begin(); iter != m_classes.end(); iter++)
+	{
+		CClassASTNode* classNode = *iter;
+
+		for (std::vector<CASTNode*>::iterator memberIter = classNode->Body->Children.begin(); memberIter != classNode->Body->Children.end(); memberIter++)
+		{
+			CClassMemberASTNode* member = dynamic_cast<CClassMemberASTNode*>(*memberIter);
+			if (member == NULL ||
+				member->MemberType != MemberType::Method ||
+				member->IsStatic == true ||
+				member->IsExtension == true ||
+				member->IsConstructor == true)
+			{
+				continue;
+			}
+
+			for (CClassASTNode* scope = classNode; scope != NULL; scope = scope->SuperClass)
+			{
+				if (scope != classNode)
+				{
+					CClassMemberASTNode* base = FindMethod(scope, member->MangledIdentifier);
+					if (base != NULL)
+					{
+						base->IsOverridden = true;
+						member->HasBaseMember = true;
+					}
+				}
+
+				std::vector<CClassASTNode*> interfaces = scope->Interfaces;
+				for (unsigned int i = 0; i < interfaces.size(); i++)
+				{
+					CClassASTNode* interfaceNode = interfaces.at(i);
+					if (FindMethod(interfaceNode, member->MangledIdentifier) != NULL)
+					{
+						member->HasBaseMember = true;
+					}
+					interfaces.insert(interfaces.end(), interfaceNode->Interfaces.begin(), interfaceNode->Interfaces.end());
+				}
+			}
+		}
+	}
+
+	// Interfaces only need to be inherited virtually if they are inherited
+	// more than once along the same class chain.
+	for (std::vector<CClassASTNode*>::iterator iter = m_classes.begin(); iter != m_classes.end(); iter++)
+	{
+		std::unordered_map<CClassASTNode*, std::vector<CClassASTNode*> > implementors;
+
+		for (CClassASTNode* scope = *iter; scope != NULL; scope = scope->SuperClass)
+		{
+			for (std::vector<CClassASTNode*>::iterator interfaceIter = scope->Interfaces.begin(); interfaceIter != scope->Interfaces.end(); interfaceIter++)
+			{
+				implementors[*interfaceIter].push_back(scope);
+			}
+		}
+
+		for (std::unordered_map<CClassASTNode*, std::vector<CClassASTNode*> >::iterator implIter = implementors.begin(); implIter != implementors.end(); implIter++)
+		{
+			if (implIter->second.size() <= 1)
+			{
+				continue;
+			}
+
+			for (std::vector<CClassASTNode*>::iterator scopeIter = implIter->second.begin(); scopeIter != implIter->second.end(); scopeIter++)
+			{
+				std::vector<CClassASTNode*>& virtualInterfaces = (*scopeIter)->VirtualInterfaces;
+				if (std::find(virtualInterfaces.begin(), virtualInterfaces.end(), implIter->first) == virtualInterfaces.end())
+				{
+					virtualInterfaces.push_back(implIter->first);
+				}
+			}
+		}
+	}
+
+	// Let the user know how much we managed to devirtualize.
+	int final_classes	= 0;
+	int classes			= 0;
+	int virtual_methods = 0;
+	int final_methods	= 0;
+
+	for (std::vector<CClassASTNode*>::iterator iter = m_classes.begin(); iter != m_classes.end(); iter++)
+	{
+		CClassASTNode* classNode = *iter;
+		if (classNode->IsInterface == true ||
+			classNode->IsNative == true)
+		{
+			continue;
+		}
+
+		classes++;
+		if (classNode->IsAbstract == false &&
+			(classNode->IsSealed == true || classNode->IsExtended == false))
+		{
+			final_classes++;
+		}
+
+		for (std::vector<CASTNode*>::iterator memberIter = classNode->Body->Children.begin(); memberIter != classNode->Body->Children.end(); memberIter++)
+		{
+			CClassMemberASTNode* member = dynamic_cast<CClassMemberASTNode*>(*memberIter);
+			if (member != NULL &&
+				member->MemberType == MemberType::Method &&
+				(member->IsVirtual == true || member->HasBaseMember == true))
+			{
+				virtual_methods++;
+				if (member->IsOverridden == false && member->IsAbstract == false)
+				{
+					final_methods++;
+				}
+			}
+		}
+	}
+
+	context->Info(CStringHelper::FormatString("Devirtualized %i of %i virtual methods, %i of %i classes are final.",
+											  final_methods, virtual_methods,
+											  final_classes, classes));
+
+	return true;
+}
+
+// =================================================================
+//	Adds a class to the hierarchy if it is going to be translated.
+// =================================================================
+void CClassHierarchy::CollectClass(CClassASTNode* node)
+{
+	if (node->IsReachable == false)
+	{
+		return;
+	}
+
+	node->IsExtended = false;
+	node->VirtualInterfaces.clear();
+
+	for (std::vector<CASTNode*>::iterator iter = node->Body->Children.begin(); iter != node->Body->Children.end(); iter++)
+	{
+		CClassMemberASTNode* member = dynamic_cast<CClassMemberASTNode*>(*iter);
+		if (member != NULL)
+		{
+			member->IsOverridden  = false;
+			member->HasBaseMember = false;
+		}
+	}
+
+	m_classes.push_back(node);
+}
+
+// =================================================================
+//	Finds the method in a class with the given mangled identifier.
+// =================================================================
+CClassMemberASTNode* CClassHierarchy::FindMethod(CClassASTNode* node, std::string mangled)
+{
+	std::unordered_map<CClassASTNode*, MethodMap>::iterator iter = m_methods.find(node);
+	if (iter == m_methods.end())
+	{
+		MethodMap methods;
+
+		for (std::vector<CASTNode*>::iterator memberIter = node->Body->Children.begin(); memberIter != node->Body->Children.end(); memberIter++)
+		{
+			CClassMemberASTNode* member = dynamic_cast<CClassMemberASTNode*>(*memberIter);
+			if (member != NULL &&
+				member->MemberType == MemberType::Method &&
+				member->IsStatic == false &&
+				member->IsExtension == false)
+			{
+				methods.insert(std::pair<std::string, CClassMemberASTNode*>(member->MangledIdentifier, member));
+			}
+		}
+
+		iter = m_methods.insert(std::pair<CClassASTNode*, MethodMap>(node, methods)).first;
+	}
+
+	MethodMap::iterator result = iter->second.find(mangled);
+	return result == iter->second.end() ? NULL : result->second;
+}
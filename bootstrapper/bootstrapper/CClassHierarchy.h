@@ -0,0 +1,42 @@
+/* *****************************************************************
+
+		CClassHierarchy.h
+
+		Copyright (C) 2012 Tim Leonard - All Rights Reserved
+
+   ***************************************************************** */
+#pragma once
+#ifndef _CCLASSHIERARCHY_H_
+#define _CCLASSHIERARCHY_H_
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+class CTranslationUnit;
+class CClassASTNode;
+class CClassMemberASTNode;
+
+// =================================================================
+//	Works out which classes are extended, which methods are
+//	overridden and which interfaces are inherited more than once
+//	along a class chain. The translator uses this to avoid virtual
+//	calls and virtual inheritance where they are not needed.
+// =================================================================
+class CClassHierarchy
+{
+private:
+	typedef std::unordered_map<std::string, CClassMemberASTNode*> MethodMap;
+
+	std::vector<CClassASTNode*>							m_classes;
+	std::unordered_map<CClassASTNode*, MethodMap>		m_methods;
+
+	void				 CollectClass	(CClassASTNode* node);
+	CClassMemberASTNode* FindMethod		(CClassASTNode* node, std::string mangled);
+
+public:
+	bool Process						(CTranslationUnit* context);
+
+};
+
+#endif
@@ -10,6 +10,8 @@
 #include <Windows.h>
 #endif
 
+#include <algorithm>
+
 #include "CStringHelper.h"
 #include "CCollectionHelper.h"
 
@@ -63,10 +65,17 @@ CClassMemberASTNode::CClassMemberASTNode(CASTNode* parent, CToken token) :
 	IsConstructor	= false;
 	IsOverride		= false;
 	IsExtension		= false;
+	IsOverridden	= true;
+	HasBaseMember	= false;
+	IsBodyDeferred	= false;
 	MemberType		= MemberType::Method;
 
+	m_body_semanted	= false;
+	m_finalized		= false;
+
 	Body			= NULL;
 	Assignment		= NULL;
+	StackAllocation	= NULL;
 	ReturnType		= NULL;
 }
 
@@ -194,6 +203,114 @@ CASTNode* CClassMemberASTNode::Semant(CSemanter* semanter)
 		CheckForDuplicateMethodIdentifier(semanter, Identifier, argument_types, this);
 	}
 
+	// Methods in generic instances are only semanted once something
+	// calls them, most instances only use a handful of their methods.
+	if (CanDeferBody(semanter) == true)
+	{
+		IsBodyDeferred = true;
+	}
+	else
+	{
+		SemantBody(semanter);
+	}
+
+	// Entry point.
+	if (Identifier == "Main")
+	{
+		if (IsStatic == false)
+		{
+			semanter->GetContext()->FatalError("Entry point is expected to be static.", Token);
+		}
+		else if (argument_types.size() != 1 || dynamic_cast<CIntDataType*>(ReturnType) == NULL || dynamic_cast<CArrayDataType*>(argument_types.at(0)) == NULL || dynamic_cast<CStringDataType*>(dynamic_cast<CArrayDataType*>(argument_types.at(0))->ElementType) == NULL)
+		{
+			semanter->GetContext()->FatalError("Entry point must match signature: int Main(string[] args).", Token);
+		}
+		else
+		{
+			CClassMemberASTNode*& node = semanter->GetContext()->GetEntryPoint();
+			if (node == NULL)
+			{
+				node = this;
+			}
+			else
+			{
+				semanter->GetContext()->FatalError("Encountered duplicate entry point", Token);
+			}
+		}
+	}
+
+	return this;
+}
+
+// =================================================================
+//	Returns true if semantic analysis of this methods body can be
+//	left until something calls it. Only non-virtual methods of 
+//	generic instances are deferred, anything that may end up in a 
+//	vtable is always semanted.
+// =================================================================
+bool CClassMemberASTNode::CanDeferBody(CSemanter* semanter)
+{
+	CClassASTNode* classScope = FindClassScope(semanter);
+
+	if (classScope->GenericInstanceOf == NULL ||
+		MemberType		!= MemberType::Method ||
+		Body			== NULL ||
+		IsConstructor	== true ||
+		IsVirtual		== true ||
+		IsOverride		== true ||
+		IsAbstract		== true ||
+		IsNative		== true ||
+		IsExtension		== true)
+	{
+		return false;
+	}
+
+	// Methods implementing interfaces are called through them, so check
+	// every interface this class picks up, from its base classes and from
+	// the interfaces themselves as well as its own.
+	std::vector<CClassASTNode*> interfaces;
+	for (CClassASTNode* scope = classScope; scope != NULL; scope = scope->SuperClass)
+	{
+		interfaces.insert(interfaces.end(), scope->Interfaces.begin(), scope->Interfaces.end());
+	}
+	for (unsigned int i = 0; i < interfaces.size(); i++)
+	{
+		CClassASTNode* interfaceClass = interfaces.at(i);
+		for (std::vector<CASTNode*>::iterator iter = interfaceClass->Body->Children.begin(); iter != interfaceClass->Body->Children.end(); iter++)
+		{
+			CClassMemberASTNode* member = dynamic_cast<CClassMemberASTNode*>(*iter);
+			if (member != NULL && member->Identifier == Identifier)
+			{
+				return false;
+			}
+		}
+
+		for (std::vector<CClassASTNode*>::iterator iter = interfaceClass->Interfaces.begin(); iter != interfaceClass->Interfaces.end(); iter++)
+		{
+			if (std::find(interfaces.begin(), interfaces.end(), *iter) == interfaces.end())
+			{
+				interfaces.push_back(*iter);
+			}
+		}
+	}
+
+	return true;
+}
+
+// =================================================================
+//	Performs semantic analysis on the body of this method.
+// =================================================================
+void CClassMemberASTNode::SemantBody(CSemanter* semanter)
+{
+	if (m_body_semanted == true)
+	{
+		return;
+	}
+	m_body_semanted = true;
+	IsBodyDeferred	= false;
+
+	CClassASTNode* classScope = FindClassScope(semanter);
+
 	// If we are a class or instance constructor then we need to
 	// add some stub code to the start.
 	if (IsConstructor == true)
@@ -245,32 +362,16 @@ CASTNode* CClassMemberASTNode::Semant(CSemanter* semanter)
 		AddDefaultReturnExpression(semanter);
 	}
 
-	// Entry point.
-	if (Identifier == "Main")
+	// If we were called after finalization we need to finalize 
+	// the body ourselves.
+	if (m_finalized == true)
 	{
-		if (IsStatic == false)
-		{
-			semanter->GetContext()->FatalError("Entry point is expected to be static.", Token);
-		}
-		else if (argument_types.size() != 1 || dynamic_cast<CIntDataType*>(ReturnType) == NULL || dynamic_cast<CArrayDataType*>(argument_types.at(0)) == NULL || dynamic_cast<CStringDataType*>(dynamic_cast<CArrayDataType*>(argument_types.at(0))->ElementType) == NULL)
+		IsReachable = true;
+		if (Body != NULL)
 		{
-			semanter->GetContext()->FatalError("Entry point must match signature: int Main(string[] args).", Token);
-		}
-		else
-		{
-			CClassMemberASTNode*& node = semanter->GetContext()->GetEntryPoint();
-			if (node == NULL)
-			{
-				node = this;
-			}
-			else
-			{
-				semanter->GetContext()->FatalError("Encountered duplicate entry point", Token);
-			}
+			Body->Finalize(semanter);
 		}
 	}
-
-	return this;
 }
 
 // =================================================================
@@ -515,6 +616,8 @@ void CClassMemberASTNode::AddInstanceConstructorPostfix(CSemanter* semanter)
 // =================================================================
 CASTNode* CClassMemberASTNode::Finalize(CSemanter* semanter)
 {
+	m_finalized = true;
+
 	// Work out mangled identifier.
 	if (MangledIdentifier == "")
 	{
@@ -596,6 +699,21 @@ CASTNode* CClassMemberASTNode::Finalize(CSemanter* semanter)
 
 	}
 	
+	// Bodies that were never semanted are not translated.
+	if (IsBodyDeferred == true)
+	{
+		IsReachable = false;
+
+		for (std::vector<CASTNode*>::iterator iter = Children.begin(); iter != Children.end(); iter++)
+		{
+			if (*iter != Body)
+			{
+				(*iter)->Finalize(semanter);
+			}
+		}
+		return this;
+	}
+
 	FinalizeChildren(semanter);
 	return this;
 }
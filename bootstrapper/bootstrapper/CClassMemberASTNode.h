@@ -21,6 +21,7 @@ class CDataType;
 class CMethodBodyASTNode;
 class CVariableStatementASTNode;
 class CClassASTNode;
+class CNewExpressionASTNode;
 
 #include "CDeclarationASTNode.h"
 
@@ -42,6 +43,10 @@ namespace MemberType
 class CClassMemberASTNode : public CDeclarationASTNode
 {
 protected:	
+	bool										m_body_semanted;
+	bool										m_finalized;
+
+	bool CanDeferBody						(CSemanter* semanter);
 
 public:
 	AccessLevel::Type							AccessLevel;
@@ -53,6 +58,18 @@ public:
 	bool										IsConstructor;
 	bool										IsExtension;
 
+	// Class hierarchy infered data.
+	bool										IsOverridden;
+	bool										HasBaseMember;
+
+	// Set on methods of generic instances whose body has not been 
+	// semanted as nothing has called them yet.
+	bool										IsBodyDeferred;
+
+	// Escape analysis infered data. Set on methods that return a new 
+	// object which some callers construct in their own storage.
+	CNewExpressionASTNode*						StackAllocation;
+
 	MemberType::Type							MemberType;		
 
 	CMethodBodyASTNode*							Body;		
@@ -72,6 +89,7 @@ public:
 	virtual CASTNode* Finalize				(CSemanter* semanter);	
 	virtual CASTNode* Clone					(CSemanter* semanter);
 	virtual void	  CheckAccess			(CSemanter* semanter, CASTNode* referenceBy);
+	void			  SemantBody			(CSemanter* semanter);
 
 	void AddClassConstructorStub			(CSemanter* semanter);
 	void AddInstanceConstructorStub			(CSemanter* semanter);
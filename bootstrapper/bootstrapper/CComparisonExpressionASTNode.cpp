@@ -93,6 +93,17 @@ CASTNode* CComparisonExpressionASTNode::Semant(CSemanter* semanter)
 	CompareResultType = ExpressionResultType;
 	ExpressionResultType = new CBoolDataType(Token);
 
+	// Fold constant comparisons.
+	if (semanter->IsConstant(LeftValue) && semanter->IsConstant(RightValue))
+	{
+		if (dynamic_cast<CBoolDataType*>(CompareResultType) == NULL ||
+			Token.Type == TokenIdentifier::OP_EQUAL ||
+			Token.Type == TokenIdentifier::OP_NOT_EQUAL)
+		{
+			return semanter->FoldConstant(this);
+		}
+	}
+
 	return this;
 }
 
@@ -106,6 +117,12 @@ EvaluationResult CComparisonExpressionASTNode::Evaluate(CTranslationUnit* unit)
 
 	if (dynamic_cast<CBoolDataType*>(CompareResultType) != NULL)
 	{
+		switch (Token.Type)
+		{		
+			case TokenIdentifier::OP_EQUAL:			return EvaluationResult(leftResult.GetBool() == rightResult.GetBool()); 
+			case TokenIdentifier::OP_NOT_EQUAL:		return EvaluationResult(leftResult.GetBool() != rightResult.GetBool());  
+			default:								break;
+		}
 	}
 	else if (dynamic_cast<CIntDataType*>(CompareResultType) != NULL)
 	{
@@ -97,9 +97,18 @@ CCompiler::CCompiler()
 	m_cmdLineParser.AddCommand("-source", "-s", CMDLINE_ARG_FLAG_STRING,							"",			"Project file that should be compiled.");
 	m_cmdLineParser.AddCommand("-config", "-c", CMDLINE_ARG_FLAG_STRING,							"Release",	"Defines what configuration to be used when compiling.");
 	m_cmdLineParser.AddCommand("-platform", "-p", CMDLINE_ARG_FLAG_STRING,							"Win32",	"Defines what platform to target when compiling.");
+	m_cmdLineParser.AddCommand("-profile", "-prof", CMDLINE_ARG_FLAG_BOOL,							"false",	"Records time spent in each compile phase and writes a chrome trace to the build directory.");
+	m_cmdLineParser.AddCommand("-noprune", "-np", CMDLINE_ARG_FLAG_BOOL,							"false",	"Translates every class and method, even if they can not be reached from the entry point.");
+	m_cmdLineParser.AddCommand("-nofold", "-nf", CMDLINE_ARG_FLAG_BOOL,								"false",	"Disables folding of constant expressions and removal of branches with constant conditions.");
+	m_cmdLineParser.AddCommand("-noescape", "-ne", CMDLINE_ARG_FLAG_BOOL,							"false",	"Disables escape analysis, every object is allocated on the garbage collected heap.");
+	m_cmdLineParser.AddCommand("-escapeinfo", "-ei", CMDLINE_ARG_FLAG_BOOL,							"false",	"Lists every object allocation site and whether it was placed on the stack or the heap.");
 
 	// Some general settings.
 	m_fileExtension	= "ls";
+	m_prune_unreachable = true;
+	m_fold_constants = true;
+	m_escape_analysis = true;
+	m_escape_info = false;
 	
 	// Make list of translators.
 	m_translators.insert(std::pair<std::string, CTranslator*>("CCPPTranslator", new CCPPTranslator()));
@@ -408,10 +417,38 @@ bool CCompiler::CompilePackage(std::string path, std::vector<CDefine> defines)
 		return false;
 	}
 
+	// Start profiling if requested.
+	m_profiler.SetEnabled(m_cmdLineParser.GetBool("-profile"));
+
+	// Strip out anything we can't reach unless asked not to.
+	m_prune_unreachable = !m_cmdLineParser.GetBool("-noprune");
+
+	// Fold constant expressions unless asked not to.
+	m_fold_constants = !m_cmdLineParser.GetBool("-nofold");
+
+	// Keep objects that never escape off the heap unless asked not to.
+	m_escape_analysis = !m_cmdLineParser.GetBool("-noescape");
+	m_escape_info = m_cmdLineParser.GetBool("-escapeinfo");
+
 	// Attempt to compile!
 	CTranslationUnit context(this, compile_file_path, m_project_config.Defines);
 	context.Compile();
 
+	// Dump profiling results.
+	if (m_profiler.IsEnabled())
+	{
+		std::string trace_path = m_buildDirectory + "/profile.json";
+		if (m_profiler.WriteTrace(trace_path))
+		{
+			printf("Wrote profile trace to: %s\n", trace_path.c_str());
+		}
+		else
+		{
+			printf("Could not write profile trace to: %s\n", trace_path.c_str());
+		}
+		m_profiler.PrintSummary();
+	}
+
 	return true;
 }
 
@@ -522,6 +559,50 @@ std::string CCompiler::GetPackageDirectory()
 	return m_packageDirectory;
 }
 
+// =================================================================
+//	Gets the profiler used to record compile timings.
+// =================================================================
+CProfiler* CCompiler::GetProfiler()
+{
+	return &m_profiler;
+}
+
+// =================================================================
+//	Returns true if unreachable classes and methods should be 
+//	pruned before translation.
+// =================================================================
+bool CCompiler::GetPruneUnreachable()
+{
+	return m_prune_unreachable;
+}
+
+// =================================================================
+//	Returns true if constant expressions should be folded during
+//	semantic analysis.
+// =================================================================
+bool CCompiler::GetFoldConstants()
+{
+	return m_fold_constants;
+}
+
+// =================================================================
+//	Returns true if objects that never escape the method that
+//	creates them should be stored on the stack.
+// =================================================================
+bool CCompiler::GetEscapeAnalysis()
+{
+	return m_escape_analysis;
+}
+
+// =================================================================
+//	Returns true if the decision made for each allocation site
+//	should be listed.
+// =================================================================
+bool CCompiler::GetEscapeInfo()
+{
+	return m_escape_info;
+}
+
 // =================================================================
 //	Gets the directory that builds are stored in.
 // =================================================================
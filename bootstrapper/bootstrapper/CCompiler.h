@@ -11,6 +11,7 @@
 
 #include <map>
 #include "CCommandLineParser.h"
+#include "CProfiler.h"
 
 class CTranslator;
 class CBuilder;
@@ -115,6 +116,12 @@ private:
 	char**								m_cmdline_args;
 	int									m_cmdline_args_count;
 
+	CProfiler							m_profiler;
+	bool								m_prune_unreachable;
+	bool								m_fold_constants;
+	bool								m_escape_analysis;
+	bool								m_escape_info;
+
 public:
 	CCompiler();
 
@@ -126,6 +133,11 @@ public:
 	CTranslator* GetTranslator			();
 	CBuilder*	 GetBuilder				();
 	CConfigState GetProjectConfig		();
+	CProfiler*	 GetProfiler			();
+	bool		 GetPruneUnreachable	();
+	bool		 GetFoldConstants		();
+	bool		 GetEscapeAnalysis		();
+	bool		 GetEscapeInfo			();
 
 	bool		 ValidateConfig			();
 
@@ -19,6 +19,7 @@
 
 #include "CSemanter.h"
 #include "CTranslationUnit.h"
+#include "CArena.h"
 
 // =================================================================
 //	Constructs a new instance of this class.
@@ -29,6 +30,39 @@ CDataType::CDataType(CToken& token) :
 {
 }
 
+// =================================================================
+//	Destructor.
+// =================================================================
+CDataType::~CDataType()
+{
+}
+
+// =================================================================
+//	Allocates memory for a new data type from the current arena.
+// =================================================================
+void* CDataType::operator new(size_t size)
+{
+	return CArena::AllocateObject(size, &CDataType::Destroy);
+}
+
+// =================================================================
+//	Frees the memory used by a data type, data types allocated from
+//	an arena are released with it.
+// =================================================================
+void CDataType::operator delete(void* ptr)
+{
+	CArena::FreeObject(ptr);
+}
+
+// =================================================================
+//	Destroys a data type that is still alive when its arena is 
+//	released.
+// =================================================================
+void CDataType::Destroy(void* ptr)
+{
+	static_cast<CDataType*>(ptr)->~CDataType();
+}
+
 // =================================================================
 //	Gets the class this data type is based on.
 // =================================================================
@@ -32,6 +32,12 @@ public:
 	CToken& Token;
 
 	CDataType(CToken& token);
+	virtual ~CDataType();
+
+	// Data types are allocated from, and owned by, the current compiles arena.
+	static void* operator new		(size_t size);
+	static void  operator delete	(void* ptr);
+	static void  Destroy			(void* ptr);
 
 	virtual CClassASTNode*	GetClass	(CSemanter* semanter);
 	virtual CClassASTNode*	GetBoxClass	(CSemanter* semanter);
@@ -20,6 +20,7 @@ CDeclarationASTNode::CDeclarationASTNode(CASTNode* parent, CToken token) :
 	Identifier			= "";
 	MangledIdentifier	= "";
 	IsNative			= false;
+	IsReachable			= true;
 }
 
 // =================================================================
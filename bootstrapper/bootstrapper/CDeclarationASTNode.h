@@ -27,6 +27,7 @@ public:
 
 	std::string MangledIdentifier;
 	bool		IsNative;
+	bool		IsReachable;
 
 	CDeclarationASTNode(CASTNode* parent, CToken token);
 
@@ -0,0 +1,793 @@
+/* *****************************************************************
+
+		CEscapeAnalysis.cpp
+
+		Copyright (C) 2012 Tim Leonard - All Rights Reserved
+
+   ***************************************************************** */
+
+#include <string>
+#include <stdio.h>
+#include <algorithm>
+
+#include "CCompiler.h"
+#include "CEscapeAnalysis.h"
+#include "CSemanter.h"
+#include "CStringHelper.h"
+#include "CProfiler.h"
+#include "CTranslationUnit.h"
+
+#include "CASTNode.h"
+#include "CClassASTNode.h"
+#include "CClassBodyASTNode.h"
+#include "CClassMemberASTNode.h"
+#include "CMethodBodyASTNode.h"
+#include "CBlockStatementASTNode.h"
+#include "CVariableStatementASTNode.h"
+#include "CReturnStatementASTNode.h"
+#include "CExpressionASTNode.h"
+#include "CExpressionBaseASTNode.h"
+#include "CAssignmentExpressionASTNode.h"
+#include "CBaseExpressionASTNode.h"
+#include "CCastExpressionASTNode.h"
+#include "CComparisonExpressionASTNode.h"
+#include "CFieldAccessExpressionASTNode.h"
+#include "CIdentifierExpressionASTNode.h"
+#include "CMethodCallExpressionASTNode.h"
+#include "CNewExpressionASTNode.h"
+#include "CThisExpressionASTNode.h"
+
+#include "CDataType.h"
+#include "CBoolDataType.h"
+#include "CFloatDataType.h"
+#include "CIntDataType.h"
+#include "CObjectDataType.h"
+#include "CStringDataType.h"
+
+// =================================================================
+//	Constructs a new instance of this class.
+// =================================================================
+CEscapeAnalysis::CEscapeAnalysis()
+{
+	m_context			= NULL;
+	m_semanter			= NULL;
+	m_report			= false;
+	m_allocations		= 0;
+	m_stack_allocations = 0;
+}
+
+// =================================================================
+//	Works out which arguments of each method escape, then decides
+//	where each object allocated by the program can be stored.
+// =================================================================
+bool CEscapeAnalysis::Process(CTranslationUnit* context)
+{
+	CProfileScope scope(context->GetCompiler()->GetProfiler(), "escape", "", context->GetFilePath());
+
+	m_context			= context;
+	m_semanter			= context->GetSemanter();
+	m_report			= context->GetCompiler()->GetEscapeInfo();
+	m_allocations		= 0;
+	m_stack_allocations = 0;
+
+	m_methods.clear();
+	m_method_set.clear();
+	m_escaping_this.clear();
+	m_escaping_arguments.clear();
+
+	// Find every method that will be translated.
+	std::vector<CASTNode*>& children = context->GetASTRoot()->Children;
+	for (std::vector<CASTNode*>::iterator iter = children.begin(); iter != children.end(); iter++)
+	{
+		CClassASTNode* classNode = dynamic_cast<CClassASTNode*>(*iter);
+		if (classNode == NULL)
+		{
+			continue;
+		}
+		if (classNode->IsGeneric == true)
+		{
+			for (std::vector<CClassASTNode*>::iterator iter2 = classNode->GenericInstances.begin(); iter2 != classNode->GenericInstances.end(); iter2++)
+			{
+				CollectClass(*iter2);
+			}
+		}
+		else
+		{
+			CollectClass(classNode);
+		}
+	}
+
+	// Start by assuming nothing escapes, then keep marking this and
+	// arguments that escape until nothing changes. Recursive calls
+	// settle on the smallest set of escaping values.
+	bool changed = true;
+	while (changed == true)
+	{
+		changed = false;
+
+		for (std::vector<CClassMemberASTNode*>::iterator iter = m_methods.begin(); iter != m_methods.end(); iter++)
+		{
+			CClassMemberASTNode* method = *iter;
+			CClassASTNode*		 classNode = dynamic_cast<CClassASTNode*>(method->Parent->Parent);
+			std::vector<CASTNode*> path;
+
+			if (m_escaping_this.find(method) == m_escaping_this.end() &&
+				DoesVariableEscape(method->Body, path, NULL, GetFinalClass(classNode), method) == true)
+			{
+				m_escaping_this.insert(method);
+				changed = true;
+			}
+
+			for (std::vector<CVariableStatementASTNode*>::iterator argIter = method->Arguments.begin(); argIter != method->Arguments.end(); argIter++)
+			{
+				CVariableStatementASTNode* arg = *argIter;
+				if (dynamic_cast<CObjectDataType*>(arg->Type) == NULL ||
+					m_escaping_arguments.find(arg) != m_escaping_arguments.end())
+				{
+					continue;
+				}
+
+				if (DoesVariableEscape(method->Body, path, arg, NULL, method) == true)
+				{
+					m_escaping_arguments.insert(arg);
+					changed = true;
+				}
+			}
+		}
+	}
+
+	// Now decide where every allocation can live.
+	for (std::vector<CClassMemberASTNode*>::iterator iter = m_methods.begin(); iter != m_methods.end(); iter++)
+	{
+		std::vector<CASTNode*> path;
+		AnalyseAllocations((*iter)->Body, path, *iter);
+	}
+
+	context->Info(CStringHelper::FormatString("Stack allocated %i of %i object allocation sites.", m_stack_allocations, m_allocations));
+
+	return true;
+}
+
+// =================================================================
+//	Adds the methods of a class to the set being analysed if they
+//	are going to be translated.
+// =================================================================
+void CEscapeAnalysis::CollectClass(CClassASTNode* node)
+{
+	if (node->IsReachable == false)
+	{
+		return;
+	}
+
+	for (std::vector<CASTNode*>::iterator iter = node->Body->Children.begin(); iter != node->Body->Children.end(); iter++)
+	{
+		CClassMemberASTNode* member = dynamic_cast<CClassMemberASTNode*>(*iter);
+		if (member == NULL ||
+			member->MemberType != MemberType::Method ||
+			member->IsReachable == false ||
+			member->IsNative == true ||
+			member->IsBodyDeferred == true ||
+			member->Body == NULL)
+		{
+			continue;
+		}
+
+		member->StackAllocation = NULL;
+
+		m_methods.push_back(member);
+		m_method_set.insert(member);
+	}
+}
+
+// =================================================================
+//	Returns the class if nothing can derive from it, so its
+//	instances are known to be of exactly that class.
+// =================================================================
+CClassASTNode* CEscapeAnalysis::GetFinalClass(CClassASTNode* node)
+{
+	if (node == NULL ||
+		node->IsInterface == true ||
+		node->IsNative == true ||
+		node->IsAbstract == true ||
+		(node->IsSealed == false && node->IsExtended == true))
+	{
+		return NULL;
+	}
+	return node;
+}
+
+// =================================================================
+//	Works out which method a call will invoke. If the class of the
+//	object being called is known it is used to resolve virtual
+//	calls, otherwise NULL is returned for any call that could be
+//	dispatched to more than one method.
+// =================================================================
+CClassMemberASTNode* CEscapeAnalysis::ResolveMethod(CClassMemberASTNode* method, CClassASTNode* dynamicClass, bool direct)
+{
+	if (method == NULL)
+	{
+		return NULL;
+	}
+
+	if (method->IsStatic == true ||
+		method->IsExtension == true ||
+		method->IsConstructor == true ||
+		direct == true)
+	{
+		return method;
+	}
+
+	if (dynamicClass != NULL)
+	{
+		for (CClassASTNode* scope = dynamicClass; scope != NULL; scope = scope->SuperClass)
+		{
+			for (std::vector<CASTNode*>::iterator iter = scope->Body->Children.begin(); iter != scope->Body->Children.end(); iter++)
+			{
+				CClassMemberASTNode* member = dynamic_cast<CClassMemberASTNode*>(*iter);
+				if (member != NULL &&
+					member->MemberType == MemberType::Method &&
+					member->IsStatic == false &&
+					member->IsExtension == false &&
+					member->IsAbstract == false &&
+					member->MangledIdentifier == method->MangledIdentifier)
+				{
+					return member;
+				}
+			}
+		}
+		return NULL;
+	}
+
+	CClassASTNode* classNode = dynamic_cast<CClassASTNode*>(method->Parent->Parent);
+	if (classNode->IsInterface == true ||
+		method->IsAbstract == true ||
+		method->IsOverridden == true)
+	{
+		return NULL;
+	}
+
+	return method;
+}
+
+// =================================================================
+//	Returns true if a method can store or return the object it is
+//	called on.
+// =================================================================
+bool CEscapeAnalysis::DoesThisEscape(CClassMemberASTNode* method)
+{
+	return method == NULL ||
+		   m_method_set.find(method) == m_method_set.end() ||
+		   m_escaping_this.find(method) != m_escaping_this.end();
+}
+
+// =================================================================
+//	Returns true if a method can store or return the object passed
+//	to the given argument.
+// =================================================================
+bool CEscapeAnalysis::DoesArgumentEscape(CClassMemberASTNode* method, unsigned int index)
+{
+	if (method == NULL ||
+		m_method_set.find(method) == m_method_set.end() ||
+		index >= method->Arguments.size())
+	{
+		return true;
+	}
+	return m_escaping_arguments.find(method->Arguments.at(index)) != m_escaping_arguments.end();
+}
+
+// =================================================================
+//	Works out if the value of the last node in the path can outlive
+//	the method it is used in. The rest of the path holds the nodes
+//	that enclose it. Anything we don't understand escapes.
+// =================================================================
+bool CEscapeAnalysis::DoesValueEscape(std::vector<CASTNode*>& path, CClassASTNode* dynamicClass, CClassMemberASTNode* method)
+{
+	bool isThis = (dynamic_cast<CThisExpressionASTNode*>(path.back()) != NULL);
+
+	for (int i = (int)path.size() - 1; i > 0; i--)
+	{
+		CASTNode* value  = path.at(i);
+		CASTNode* parent = path.at(i - 1);
+
+		// Expression statements throw their value away.
+		if (dynamic_cast<CBlockStatementASTNode*>(parent) != NULL ||
+			dynamic_cast<CMethodBodyASTNode*>(parent) != NULL)
+		{
+			return dynamic_cast<CExpressionASTNode*>(value) == NULL;
+		}
+
+		// Brackets pass the value straight through.
+		if (dynamic_cast<CExpressionASTNode*>(parent) != NULL)
+		{
+			continue;
+		}
+
+		// Casting between objects gives the same object, casting it to a
+		// string calls ToString and casting it to any other primitive just 
+		// tests it against null.
+		CCastExpressionASTNode* castNode = dynamic_cast<CCastExpressionASTNode*>(parent);
+		if (castNode != NULL)
+		{
+			if (dynamic_cast<CObjectDataType*>(castNode->Type) != NULL)
+			{
+				continue;
+			}
+			if (dynamic_cast<CStringDataType*>(castNode->Type) != NULL)
+			{
+				return dynamicClass == NULL ||
+					   DoesThisEscape(dynamicClass->FindClassMethod(m_semanter, "ToString", std::vector<CDataType*>(), true));
+			}
+			return dynamic_cast<CBoolDataType*>(castNode->Type)	 == NULL &&
+				   dynamic_cast<CIntDataType*>(castNode->Type)	 == NULL &&
+				   dynamic_cast<CFloatDataType*>(castNode->Type) == NULL;
+		}
+
+		// Calling a method on the value, or passing it as an argument, is
+		// safe as long as the method called does not let it escape.
+		CMethodCallExpressionASTNode* callNode = dynamic_cast<CMethodCallExpressionASTNode*>(parent);
+		if (callNode != NULL)
+		{
+			CClassMemberASTNode* member = dynamic_cast<CClassMemberASTNode*>(callNode->ResolvedDeclaration);
+
+			if (callNode->LeftValue == value)
+			{
+				if (member != NULL && member->IsStatic == true)
+				{
+					return false;
+				}
+
+				bool direct = (dynamic_cast<CBaseExpressionASTNode*>(value) != NULL);
+				return DoesThisEscape(ResolveMethod(member, dynamicClass, direct));
+			}
+
+			std::vector<CASTNode*>::iterator argIter = std::find(callNode->ArgumentExpressions.begin(), callNode->ArgumentExpressions.end(), value);
+			if (argIter == callNode->ArgumentExpressions.end())
+			{
+				return true;
+			}
+
+			bool direct = (dynamic_cast<CBaseExpressionASTNode*>(callNode->LeftValue) != NULL);
+			return DoesArgumentEscape(ResolveMethod(member, NULL, direct), argIter - callNode->ArgumentExpressions.begin());
+		}
+
+		// Passing it to a constructor.
+		CNewExpressionASTNode* newNode = dynamic_cast<CNewExpressionASTNode*>(parent);
+		if (newNode != NULL)
+		{
+			std::vector<CASTNode*>::iterator argIter = std::find(newNode->ArgumentExpressions.begin(), newNode->ArgumentExpressions.end(), value);
+			if (newNode->IsArray == true ||
+				argIter == newNode->ArgumentExpressions.end())
+			{
+				return true;
+			}
+
+			return DoesArgumentEscape(newNode->ResolvedConstructor, argIter - newNode->ArgumentExpressions.begin());
+		}
+
+		// Reading or writing one of its fields.
+		CFieldAccessExpressionASTNode* fieldNode = dynamic_cast<CFieldAccessExpressionASTNode*>(parent);
+		if (fieldNode != NULL)
+		{
+			return fieldNode->LeftValue != value;
+		}
+
+		// Comparing it against another object.
+		if (dynamic_cast<CComparisonExpressionASTNode*>(parent) != NULL)
+		{
+			return false;
+		}
+
+		// Overwriting the variable that holds it.
+		CAssignmentExpressionASTNode* assignNode = dynamic_cast<CAssignmentExpressionASTNode*>(parent);
+		if (assignNode != NULL)
+		{
+			return assignNode->LeftValue != value;
+		}
+
+		// Constructors return the object they construct, which is the
+		// result of the new expression that invoked them.
+		if (dynamic_cast<CReturnStatementASTNode*>(parent) != NULL)
+		{
+			return isThis == false || method->IsConstructor == false;
+		}
+
+		return true;
+	}
+
+	return true;
+}
+
+// =================================================================
+//	Looks for any use of a variable, or of this if no variable is
+//	given, that lets its value escape.
+// =================================================================
+bool CEscapeAnalysis::DoesVariableEscape(CASTNode* node, std::vector<CASTNode*>& path, CVariableStatementASTNode* variable, CClassASTNode* dynamicClass, CClassMemberASTNode* method)
+{
+	if (node == NULL)
+	{
+		return false;
+	}
+
+	path.push_back(node);
+
+	bool isUse = false;
+	if (variable == NULL)
+	{
+		isUse = (dynamic_cast<CThisExpressionASTNode*>(node) != NULL ||
+				 dynamic_cast<CBaseExpressionASTNode*>(node) != NULL);
+	}
+	else
+	{
+		CIdentifierExpressionASTNode* identNode = dynamic_cast<CIdentifierExpressionASTNode*>(node);
+		isUse = (identNode != NULL && identNode->ResolvedDeclaration == variable);
+	}
+
+	bool result = (isUse == true && DoesValueEscape(path, dynamicClass, method) == true);
+
+	for (std::vector<CASTNode*>::iterator iter = node->Children.begin(); result == false && iter != node->Children.end(); iter++)
+	{
+		result = DoesVariableEscape(*iter, path, variable, dynamicClass, method);
+	}
+
+	path.pop_back();
+
+	return result;
+}
+
+// =================================================================
+//	Returns true if instances of the class created by the given
+//	new expression can be stored outside of the heap at all, if not
+//	the reason why is returned.
+// =================================================================
+bool CEscapeAnalysis::CanStackAllocate(CNewExpressionASTNode* node, std::string& reason)
+{
+	CClassASTNode* classNode = node->DataType->GetClass(m_semanter);
+
+	if (classNode->IsNative == true)
+	{
+		reason = "class is native";
+		return false;
+	}
+	if (GetFinalClass(classNode) == NULL)
+	{
+		reason = "class is not sealed";
+		return false;
+	}
+	if (DoesThisEscape(node->ResolvedConstructor) == true)
+	{
+		reason = "constructor lets the object escape";
+		return false;
+	}
+
+	return true;
+}
+
+// =================================================================
+//	If the method does nothing but return a new object, returns the
+//	new expression that creates it.
+// =================================================================
+CNewExpressionASTNode* CEscapeAnalysis::GetFactoryAllocation(CClassMemberASTNode* method)
+{
+	if (method == NULL ||
+		m_method_set.find(method) == m_method_set.end() ||
+		method->Body->Children.size() != 1)
+	{
+		return NULL;
+	}
+
+	CReturnStatementASTNode* returnNode = dynamic_cast<CReturnStatementASTNode*>(method->Body->Children.at(0));
+	if (returnNode == NULL)
+	{
+		return NULL;
+	}
+
+	CASTNode* value = returnNode->ReturnExpression;
+	while (value != NULL)
+	{
+		CExpressionASTNode*		exprNode = dynamic_cast<CExpressionASTNode*>(value);
+		CCastExpressionASTNode* castNode = dynamic_cast<CCastExpressionASTNode*>(value);
+
+		if (exprNode != NULL)
+		{
+			value = exprNode->LeftValue;
+		}
+		else if (castNode != NULL && dynamic_cast<CObjectDataType*>(castNode->Type) != NULL)
+		{
+			value = castNode->RightValue;
+		}
+		else
+		{
+			break;
+		}
+	}
+
+	CNewExpressionASTNode* newNode = dynamic_cast<CNewExpressionASTNode*>(value);
+	if (newNode == NULL || newNode->IsArray == true)
+	{
+		return NULL;
+	}
+
+	return newNode;
+}
+
+// =================================================================
+//	Decides where to store every object allocated in the given node
+//	and its children.
+// =================================================================
+void CEscapeAnalysis::AnalyseAllocations(CASTNode* node, std::vector<CASTNode*>& path, CClassMemberASTNode* method)
+{
+	if (node == NULL)
+	{
+		return;
+	}
+
+	path.push_back(node);
+
+	CNewExpressionASTNode* newNode = dynamic_cast<CNewExpressionASTNode*>(node);
+	if (newNode != NULL && newNode->IsArray == false)
+	{
+		AnalyseAllocation(newNode, path, method);
+	}
+
+	CVariableStatementASTNode* varNode = dynamic_cast<CVariableStatementASTNode*>(node);
+	if (varNode != NULL)
+	{
+		CASTNode* value = varNode->AssignmentExpression;
+		while (dynamic_cast<CExpressionASTNode*>(value) != NULL)
+		{
+			value = dynamic_cast<CExpressionASTNode*>(value)->LeftValue;
+		}
+
+		CMethodCallExpressionASTNode* callNode = dynamic_cast<CMethodCallExpressionASTNode*>(value);
+		if (callNode != NULL)
+		{
+			AnalyseFactoryCall(varNode, callNode, path, method);
+		}
+	}
+
+	CMethodCallExpressionASTNode* callNode = dynamic_cast<CMethodCallExpressionASTNode*>(node);
+	if (callNode != NULL && callNode->StackAllocation == NULL)
+	{
+		AnalyseFactoryCall(NULL, callNode, path, method);
+	}
+
+	for (std::vector<CASTNode*>::iterator iter = node->Children.begin(); iter != node->Children.end(); iter++)
+	{
+		AnalyseAllocations(*iter, path, method);
+	}
+
+	path.pop_back();
+}
+
+// =================================================================
+//	Decides where to store the object created by a new expression.
+//	Objects that initialize a local that never escapes are stored
+//	in a local alongside it, objects that never escape the
+//	expression they are created in are stored in a temporary.
+// =================================================================
+void CEscapeAnalysis::AnalyseAllocation(CNewExpressionASTNode* node, std::vector<CASTNode*>& path, CClassMemberASTNode* method)
+{
+	CClassASTNode* classNode = node->DataType->GetClass(m_semanter);
+	std::string	   name		 = classNode->ToString();
+	std::string	   reason	 = "";
+
+	m_allocations++;
+
+	if (CanStackAllocate(node, reason) == false)
+	{
+		Report(CStringHelper::FormatString("Allocated '%s' on the heap, %s.", name.c_str(), reason.c_str()), node->Token);
+		return;
+	}
+
+	// Skip over anything that passes the object straight through.
+	int index = (int)path.size() - 1;
+	while (index > 0)
+	{
+		CCastExpressionASTNode* castNode = dynamic_cast<CCastExpressionASTNode*>(path.at(index - 1));
+		if (dynamic_cast<CExpressionASTNode*>(path.at(index - 1)) != NULL ||
+			(castNode != NULL && dynamic_cast<CObjectDataType*>(castNode->Type) != NULL))
+		{
+			index--;
+		}
+		else
+		{
+			break;
+		}
+	}
+
+	// Initializing a local variable?
+	CVariableStatementASTNode* varNode = index > 1 ? dynamic_cast<CVariableStatementASTNode*>(path.at(index - 1)) : NULL;
+	if (varNode != NULL &&
+		varNode->AssignmentExpression == path.at(index) &&
+		varNode->IsParameter == false &&
+		(dynamic_cast<CBlockStatementASTNode*>(path.at(index - 2)) != NULL ||
+		 dynamic_cast<CMethodBodyASTNode*>(path.at(index - 2)) != NULL))
+	{
+		std::vector<CASTNode*> varPath;
+		if (DoesVariableEscape(method->Body, varPath, varNode, classNode, method) == true)
+		{
+			Report(CStringHelper::FormatString("Allocated '%s' on the heap, local '%s' escapes.", name.c_str(), varNode->Identifier.c_str()), node->Token);
+			return;
+		}
+
+		node->Allocation = AllocationType::Local;
+		m_stack_allocations++;
+
+		if (IsVariableAssigned(method->Body, varNode) == false)
+		{
+			varNode->StackClass = classNode;
+		}
+
+		Report(CStringHelper::FormatString("Allocated '%s' on the stack, stored alongside local '%s'.", name.c_str(), varNode->Identifier.c_str()), node->Token);
+		return;
+	}
+
+	// Used and discarded in a single expression?
+	if (DoesValueEscape(path, classNode, method) == true)
+	{
+		Report(CStringHelper::FormatString("Allocated '%s' on the heap, it escapes.", name.c_str()), node->Token);
+		return;
+	}
+
+	node->Allocation = AllocationType::Temporary;
+	m_stack_allocations++;
+
+	Report(CStringHelper::FormatString("Allocated '%s' on the stack, stored in a temporary.", name.c_str()), node->Token);
+}
+
+// =================================================================
+//	Checks if a call is to a method that just returns a new object.
+//	If the object never escapes the caller can provide the storage
+//	for it, either alongside the local the call initializes or in
+//	a temporary. This covers the enumerators created by foreach
+//	loops and the boxes they return.
+// =================================================================
+void CEscapeAnalysis::AnalyseFactoryCall(CVariableStatementASTNode* node, CMethodCallExpressionASTNode* call, std::vector<CASTNode*>& path, CClassMemberASTNode* method)
+{
+	if (node != NULL &&
+		(node->IsParameter == true ||
+		 path.size() < 2 ||
+		 (dynamic_cast<CBlockStatementASTNode*>(path.at(path.size() - 2)) == NULL &&
+		  dynamic_cast<CMethodBodyASTNode*>(path.at(path.size() - 2)) == NULL)))
+	{
+		return;
+	}
+
+	// Work out exactly which method is being called.
+	CClassMemberASTNode* member = dynamic_cast<CClassMemberASTNode*>(call->ResolvedDeclaration);
+	CClassASTNode*		 leftClass = GetReceiverClass(call);
+	bool				 direct = (dynamic_cast<CBaseExpressionASTNode*>(call->LeftValue) != NULL);
+
+	CClassMemberASTNode* target = ResolveMethod(member, leftClass, direct);
+	if (target != NULL && leftClass != NULL)
+	{
+		call->ResolvedTarget = target;
+	}
+
+	CNewExpressionASTNode* newNode = GetFactoryAllocation(target);
+	if (newNode == NULL)
+	{
+		return;
+	}
+
+	CClassASTNode* classNode = newNode->DataType->GetClass(m_semanter);
+	std::string	   name		 = classNode->ToString();
+	std::string	   reason	 = "";
+
+	m_allocations++;
+
+	if (CanStackAllocate(newNode, reason) == false)
+	{
+		Report(CStringHelper::FormatString("Allocated '%s' returned by '%s' on the heap, %s.", name.c_str(), target->Identifier.c_str(), reason.c_str()), call->Token);
+		return;
+	}
+
+	// Initializing a local variable?
+	if (node != NULL)
+	{
+		std::vector<CASTNode*> varPath;
+		if (DoesVariableEscape(method->Body, varPath, node, classNode, method) == true)
+		{
+			Report(CStringHelper::FormatString("Allocated '%s' returned by '%s' on the heap, local '%s' escapes.", name.c_str(), target->Identifier.c_str(), node->Identifier.c_str()), call->Token);
+			return;
+		}
+
+		call->Allocation = AllocationType::Local;
+
+		if (IsVariableAssigned(method->Body, node) == false)
+		{
+			node->StackClass = classNode;
+		}
+
+		Report(CStringHelper::FormatString("Allocated '%s' returned by '%s' on the stack, stored alongside local '%s'.", name.c_str(), target->Identifier.c_str(), node->Identifier.c_str()), call->Token);
+	}
+
+	// Used and discarded in a single expression?
+	else
+	{
+		if (DoesValueEscape(path, classNode, method) == true)
+		{
+			Report(CStringHelper::FormatString("Allocated '%s' returned by '%s' on the heap, it escapes.", name.c_str(), target->Identifier.c_str()), call->Token);
+			return;
+		}
+
+		call->Allocation = AllocationType::Temporary;
+
+		Report(CStringHelper::FormatString("Allocated '%s' returned by '%s' on the stack, stored in a temporary.", name.c_str(), target->Identifier.c_str()), call->Token);
+	}
+
+	call->StackAllocation	= newNode;
+	call->ResolvedTarget	= target;
+	target->StackAllocation = newNode;
+	m_stack_allocations++;
+}
+
+// =================================================================
+//	Returns the exact class of the object a method is being called
+//	on, or NULL if it could be one of several.
+// =================================================================
+CClassASTNode* CEscapeAnalysis::GetReceiverClass(CMethodCallExpressionASTNode* call)
+{
+	CIdentifierExpressionASTNode* identNode = dynamic_cast<CIdentifierExpressionASTNode*>(call->LeftValue);
+	if (identNode != NULL)
+	{
+		CVariableStatementASTNode* varNode = dynamic_cast<CVariableStatementASTNode*>(identNode->ResolvedDeclaration);
+		if (varNode != NULL && varNode->StackClass != NULL)
+		{
+			return varNode->StackClass;
+		}
+	}
+
+	CExpressionBaseASTNode* leftNode = dynamic_cast<CExpressionBaseASTNode*>(call->LeftValue);
+	if (leftNode != NULL && dynamic_cast<CObjectDataType*>(leftNode->ExpressionResultType) != NULL)
+	{
+		return GetFinalClass(leftNode->ExpressionResultType->GetClass(m_semanter));
+	}
+
+	return NULL;
+}
+
+// =================================================================
+//	Returns true if a variable is assigned to anywhere other than
+//	its declaration.
+// =================================================================
+bool CEscapeAnalysis::IsVariableAssigned(CASTNode* node, CVariableStatementASTNode* variable)
+{
+	CAssignmentExpressionASTNode* assignNode = dynamic_cast<CAssignmentExpressionASTNode*>(node);
+	if (assignNode != NULL)
+	{
+		CASTNode* value = assignNode->LeftValue;
+		while (dynamic_cast<CExpressionASTNode*>(value) != NULL)
+		{
+			value = dynamic_cast<CExpressionASTNode*>(value)->LeftValue;
+		}
+
+		CIdentifierExpressionASTNode* identNode = dynamic_cast<CIdentifierExpressionASTNode*>(value);
+		if (identNode != NULL && identNode->ResolvedDeclaration == variable)
+		{
+			return true;
+		}
+	}
+
+	for (std::vector<CASTNode*>::iterator iter = node->Children.begin(); iter != node->Children.end(); iter++)
+	{
+		if (IsVariableAssigned(*iter, variable) == true)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// =================================================================
+//	Lets the user know what was decided for an allocation site, if
+//	they asked to know.
+// =================================================================
+void CEscapeAnalysis::Report(std::string message, CToken& token)
+{
+	if (m_report == true)
+	{
+		m_context->Info(message, token);
+	}
+}
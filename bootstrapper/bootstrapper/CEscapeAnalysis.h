@@ -0,0 +1,75 @@
+/* *****************************************************************
+
+		CEscapeAnalysis.h
+
+		Copyright (C) 2012 Tim Leonard - All Rights Reserved
+
+   ***************************************************************** */
+#pragma once
+#ifndef _CESCAPEANALYSIS_H_
+#define _CESCAPEANALYSIS_H_
+
+#include <string>
+#include <vector>
+#include <unordered_set>
+
+class CTranslationUnit;
+class CSemanter;
+class CToken;
+class CASTNode;
+class CClassASTNode;
+class CClassMemberASTNode;
+class CVariableStatementASTNode;
+class CNewExpressionASTNode;
+class CMethodCallExpressionASTNode;
+
+// =================================================================
+//	Works out which objects never outlive the method that creates
+//	them. The translator constructs these in stack storage rather
+//	than allocating them on the garbage collected heap.
+// =================================================================
+class CEscapeAnalysis
+{
+private:
+	CTranslationUnit*									m_context;
+	CSemanter*											m_semanter;
+
+	std::vector<CClassMemberASTNode*>					m_methods;
+	std::unordered_set<CClassMemberASTNode*>			m_method_set;
+
+	std::unordered_set<CClassMemberASTNode*>			m_escaping_this;
+	std::unordered_set<CVariableStatementASTNode*>		m_escaping_arguments;
+
+	bool												m_report;
+	int													m_allocations;
+	int													m_stack_allocations;
+
+	void					CollectClass			(CClassASTNode* node);
+
+	CClassASTNode*			GetFinalClass			(CClassASTNode* node);
+	CClassASTNode*			GetReceiverClass		(CMethodCallExpressionASTNode* call);
+	CClassMemberASTNode*	ResolveMethod			(CClassMemberASTNode* method, CClassASTNode* dynamicClass, bool direct);
+	bool					DoesThisEscape			(CClassMemberASTNode* method);
+	bool					DoesArgumentEscape		(CClassMemberASTNode* method, unsigned int index);
+
+	bool					DoesValueEscape			(std::vector<CASTNode*>& path, CClassASTNode* dynamicClass, CClassMemberASTNode* method);
+	bool					DoesVariableEscape		(CASTNode* node, std::vector<CASTNode*>& path, CVariableStatementASTNode* variable, CClassASTNode* dynamicClass, CClassMemberASTNode* method);
+	bool					IsVariableAssigned		(CASTNode* node, CVariableStatementASTNode* variable);
+
+	bool					CanStackAllocate		(CNewExpressionASTNode* node, std::string& reason);
+	CNewExpressionASTNode*	GetFactoryAllocation	(CClassMemberASTNode* method);
+
+	void					AnalyseAllocations		(CASTNode* node, std::vector<CASTNode*>& path, CClassMemberASTNode* method);
+	void					AnalyseAllocation		(CNewExpressionASTNode* node, std::vector<CASTNode*>& path, CClassMemberASTNode* method);
+	void					AnalyseFactoryCall		(CVariableStatementASTNode* node, CMethodCallExpressionASTNode* call, std::vector<CASTNode*>& path, CClassMemberASTNode* method);
+
+	void					Report					(std::string message, CToken& token);
+
+public:
+	CEscapeAnalysis();
+
+	bool Process									(CTranslationUnit* context);
+
+};
+
+#endif
@@ -16,6 +16,8 @@
 #include "CClassReferenceDataType.h"
 
 #include "CClassMemberASTNode.h"
+#include "CExpressionASTNode.h"
+#include "CLiteralExpressionASTNode.h"
 
 #include "CThisExpressionASTNode.h"
 #include "CClassRefExpressionASTNode.h"
@@ -136,6 +138,21 @@ CASTNode* CFieldAccessExpressionASTNode::Clone(CSemanter* semanter)
 	return clone;
 }
 
+// =================================================================
+//	Evalulates the constant value of this node.
+// =================================================================
+EvaluationResult CFieldAccessExpressionASTNode::Evaluate(CTranslationUnit* unit)
+{
+	if (ExpressionResultClassMember != NULL &&
+		ExpressionResultClassMember->IsConst == true &&
+		ExpressionResultClassMember->Assignment != NULL &&
+		dynamic_cast<CLiteralExpressionASTNode*>(ExpressionResultClassMember->Assignment->LeftValue) != NULL)
+	{
+		return ExpressionResultClassMember->Assignment->Evaluate(unit);
+	}
+	return CExpressionBaseASTNode::Evaluate(unit);
+}
+
 // =================================================================
 //	Causes this node to be translated.
 // =================================================================
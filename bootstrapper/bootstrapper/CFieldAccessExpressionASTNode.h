@@ -37,6 +37,8 @@ public:
 	virtual CASTNode* Clone									(CSemanter* semanter);
 	virtual CASTNode* Semant								(CSemanter* semanter);
 	
+	virtual EvaluationResult Evaluate(CTranslationUnit* unit);
+
 	virtual std::string TranslateExpr(CTranslator* translator);
 
 };
@@ -10,6 +10,8 @@
 #include "CDeclarationASTNode.h"
 #include "CClassASTNode.h"
 #include "CClassMemberASTNode.h"
+#include "CExpressionASTNode.h"
+#include "CLiteralExpressionASTNode.h"
 #include "CVariableStatementASTNode.h"
 
 #include "CStringHelper.h"
@@ -175,6 +177,21 @@ CASTNode* CIdentifierExpressionASTNode::Semant(CSemanter* semanter)
 	return this;
 }
 
+// =================================================================
+//	Evalulates the constant value of this node.
+// =================================================================
+EvaluationResult CIdentifierExpressionASTNode::Evaluate(CTranslationUnit* unit)
+{
+	if (ExpressionResultClassMember != NULL &&
+		ExpressionResultClassMember->IsConst == true &&
+		ExpressionResultClassMember->Assignment != NULL &&
+		dynamic_cast<CLiteralExpressionASTNode*>(ExpressionResultClassMember->Assignment->LeftValue) != NULL)
+	{
+		return ExpressionResultClassMember->Assignment->Evaluate(unit);
+	}
+	return CExpressionBaseASTNode::Evaluate(unit);
+}
+
 // =================================================================
 //	Causes this node to be translated.
 // =================================================================
@@ -58,6 +58,13 @@ CASTNode* CIfStatementASTNode::Semant(CSemanter* semanter)
 		ElseStatement = ReplaceChild(ElseStatement, ElseStatement->Semant(semanter));
 	}
 
+	// Remove the branch that can never be taken.
+	if (semanter->IsConstant(ExpressionStatement))
+	{
+		bool result = ExpressionStatement->Evaluate(semanter->GetContext()).GetBool();
+		return semanter->FoldBranch(this, result == true ? BodyStatement : ElseStatement);
+	}
+
 	return this;
 }
 
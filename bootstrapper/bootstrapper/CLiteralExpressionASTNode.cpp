@@ -72,7 +72,12 @@ EvaluationResult CLiteralExpressionASTNode::Evaluate(CTranslationUnit* unit)
 	}
 	else if (dynamic_cast<CIntDataType*>(ExpressionResultType) != NULL)
 	{
-		return EvaluationResult(CStringHelper::ToInt(Literal));
+		// Hexidecimal literals are not understood by ToInt. Literals that 
+		// don't fit in an int are never treated as constant, see
+		// CSemanter::IsConstant.
+		int value = 0;
+		CStringHelper::TryToInt(Literal, value);
+		return EvaluationResult(value);
 	}
 	else if (dynamic_cast<CFloatDataType*>(ExpressionResultType) != NULL)
 	{
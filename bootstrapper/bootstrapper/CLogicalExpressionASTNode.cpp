@@ -8,6 +8,7 @@
 
 #include "CLogicalExpressionASTNode.h"
 #include "CTranslationUnit.h"
+#include "CSemanter.h"
 
 #include "CBoolDataType.h"
 
@@ -71,6 +72,27 @@ CASTNode* CLogicalExpressionASTNode::Semant(CSemanter* semanter)
 	LeftValue  = ReplaceChild(LeftValue,  leftValueBase->CastTo(semanter, ExpressionResultType, Token, true));
 	RightValue = ReplaceChild(RightValue, rightValueBase->CastTo(semanter, ExpressionResultType, Token, true)); 
 
+	// Fold constant expressions. If only the left value is constant we can 
+	// still short-circuit, as the right value will either always or never
+	// be evaluated.
+	if (semanter->IsConstant(LeftValue))
+	{
+		if (semanter->IsConstant(RightValue))
+		{
+			return semanter->FoldConstant(this);
+		}
+
+		bool leftResult = LeftValue->Evaluate(semanter->GetContext()).GetBool();
+		if (Token.Type == TokenIdentifier::OP_LOGICAL_AND)
+		{
+			return leftResult == true ? RightValue : semanter->FoldConstant(this, EvaluationResult(false));
+		}
+		else if (Token.Type == TokenIdentifier::OP_LOGICAL_OR)
+		{
+			return leftResult == false ? RightValue : semanter->FoldConstant(this, EvaluationResult(true));
+		}
+	}
+
 	return this;
 }
 
@@ -85,7 +107,7 @@ EvaluationResult CLogicalExpressionASTNode::Evaluate(CTranslationUnit* unit)
 	switch (Token.Type)
 	{		
 		case TokenIdentifier::OP_LOGICAL_AND:		return EvaluationResult(leftResult.GetBool() && rightResult.GetBool()); 
-		case TokenIdentifier::OP_LOGICAL_OR:		return EvaluationResult(leftResult.GetBool() && rightResult.GetBool());
+		case TokenIdentifier::OP_LOGICAL_OR:		return EvaluationResult(leftResult.GetBool() || rightResult.GetBool());
 	}
 	
 	unit->FatalError("Invalid constant operation.", Token);
@@ -130,6 +130,18 @@ bool CMakeBuilder::Build()
 		}
 	}
 	
+	// Link time optimization has to be passed to both the compiler and linker.
+	std::string lto = project_config.GetString("MAKE_LTO", "Off", false);
+	std::string lto_flags = "";
+	if (lto == "On")
+	{
+		lto_flags = " -flto";
+	}
+	else if (lto != "Off")
+	{
+		m_context->FatalError("Unknown link time optimization mode '" + lto + "', expected On or Off.");
+	}
+
 	std::string solution_file_path = build_dir + "/makefile";
 	std::string solution_file = "";
 	
@@ -161,8 +173,8 @@ bool CMakeBuilder::Build()
 	solution_file += std::string("OBJECT_FILES = ") + object_file_string + "\n";
 	solution_file += std::string("") + "\n";	
 	solution_file += std::string("CC		   = g++\n");
-	solution_file += std::string("CFLAGS	   = -w -c -I ") + CPathHelper::GetAbsolutePath(build_dir) + " " + project_config.GetString("MAKE_CFLAGS") + "\n";
-	solution_file += std::string("LDFLAGS	   = ") +  project_config.GetString("MAKE_LDFLAGS") + "\n";
+	solution_file += std::string("CFLAGS	   = -w -c -pthread -I ") + CPathHelper::GetAbsolutePath(build_dir) + " " + project_config.GetString("MAKE_CFLAGS") + lto_flags + "\n";
+	solution_file += std::string("LDFLAGS	   = -pthread ") +  project_config.GetString("MAKE_LDFLAGS") + lto_flags + "\n";
 	solution_file += std::string("") + "\n";		
 	solution_file += std::string(".PHONY: all clean") + "\n";
 	solution_file += std::string("") + "\n";		
@@ -174,7 +186,9 @@ bool CMakeBuilder::Build()
 	solution_file += std::string("") + "\n";
 	solution_file += std::string("%.o: %.$(SOURCE_EXT)") + "\n";
 	solution_file += std::string("	@echo \"Compiling $<...\"") + "\n";
-	solution_file += std::string("	@$(CC) $(CFLAGS) $< -o $@") + "\n";
+	solution_file += std::string("	@$(CC) $(CFLAGS) -MMD -MP $< -o $@") + "\n";
+	solution_file += std::string("") + "\n";		
+	solution_file += std::string("-include $(patsubst %.o,%.d,$(filter %.o,$(OBJECT_FILES)))") + "\n";
 	solution_file += std::string("") + "\n";		
 	solution_file += std::string("clean:") + "\n";
 	solution_file += std::string("	$(RM) -r $(OBJECT_DIR)") + "\n";
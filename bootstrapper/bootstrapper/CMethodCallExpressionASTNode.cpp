@@ -36,7 +36,10 @@ CMethodCallExpressionASTNode::CMethodCallExpressionASTNode(CASTNode* parent, CTo
 	CExpressionBaseASTNode(parent, token),
 	LeftValue(NULL),
 	RightValue(NULL),
-	ResolvedDeclaration(NULL)
+	ResolvedDeclaration(NULL),
+	StackAllocation(NULL),
+	Allocation(AllocationType::Heap),
+	ResolvedTarget(NULL)
 {
 }
 
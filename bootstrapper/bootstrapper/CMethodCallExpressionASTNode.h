@@ -16,6 +16,9 @@
 #include "CASTNode.h"
 
 #include "CExpressionBaseASTNode.h"
+#include "CNewExpressionASTNode.h"
+
+class CClassMemberASTNode;
 
 // =================================================================
 //	Stores information on an expression.
@@ -30,6 +33,12 @@ public:
 	CASTNode* LeftValue;
 	CDeclarationASTNode* ResolvedDeclaration;
 
+	// Escape analysis infered data. Set when the object returned by the
+	// method never escapes, the caller then provides the storage for it.
+	CNewExpressionASTNode* StackAllocation;
+	AllocationType::Type Allocation;
+	CClassMemberASTNode* ResolvedTarget; // Exact method invoked, when it is known.
+
 	CMethodCallExpressionASTNode(CASTNode* parent, CToken token);
 
 	virtual CASTNode* Clone		(CSemanter* semanter);
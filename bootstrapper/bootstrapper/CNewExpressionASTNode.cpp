@@ -35,7 +35,8 @@ CNewExpressionASTNode::CNewExpressionASTNode(CASTNode* parent, CToken token) :
 	DataType(NULL),
 	IsArray(false),
 	ResolvedConstructor(NULL),
-	ArrayInitializer(NULL)
+	ArrayInitializer(NULL),
+	Allocation(AllocationType::Heap)
 {
 }
 
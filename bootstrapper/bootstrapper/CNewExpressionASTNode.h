@@ -20,6 +20,19 @@
 class CDataType;
 class CArrayInitializerASTNode;
 
+// =================================================================
+//	Where the object created by a new expression is stored.
+// =================================================================
+namespace AllocationType
+{
+	enum Type
+	{
+		Heap,
+		Local,
+		Temporary
+	};
+};
+
 // =================================================================
 //	Stores information on an expression.
 // =================================================================
@@ -34,6 +47,9 @@ public:
 	std::vector<CASTNode*>		ArgumentExpressions;
 	CArrayInitializerASTNode*	ArrayInitializer;
 
+	// Escape analysis infered data.
+	AllocationType::Type		Allocation;
+
 	CNewExpressionASTNode(CASTNode* parent, CToken token);
 
 	virtual CASTNode* Clone(CSemanter* semanter);
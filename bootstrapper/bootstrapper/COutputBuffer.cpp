@@ -0,0 +1,157 @@
+/* *****************************************************************
+
+		COutputBuffer.cpp
+
+		Copyright (C) 2012 Tim Leonard - All Rights Reserved
+
+   ***************************************************************** */
+
+#include "COutputBuffer.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+
+// =================================================================
+//	Constructs a new instance of this class.
+// =================================================================
+COutputBuffer::COutputBuffer() :
+	m_indent_level(0),
+	m_last_was_newline(false),
+	m_format_buffer(1024)
+{
+	m_text.reserve(OUTPUT_BUFFER_RESERVE);
+}
+
+// =================================================================
+//	Gets the indentation for the given level, building and caching
+//	it the first time it is used.
+// =================================================================
+const std::string& COutputBuffer::GetIndent(int level)
+{
+	if (level < 0)
+	{
+		level = 0;
+	}
+
+	while ((int)m_indents.size() <= level)
+	{
+		m_indents.push_back(std::string(m_indents.size(), '\t'));
+	}
+
+	return m_indents[level];
+}
+
+// =================================================================
+//	Indents the start of a line and tracks the indentation level
+//	from the first character of the text about to be written.
+// =================================================================
+void COutputBuffer::BeginText(char first)
+{
+	if (first == '{')
+	{
+		if (m_last_was_newline == true)
+		{
+			m_text += GetIndent(m_indent_level);
+		}
+		m_indent_level++;
+	}
+	else if (first == '}')
+	{
+		m_indent_level--;
+		if (m_last_was_newline == true)
+		{
+			m_text += GetIndent(m_indent_level);
+		}
+	}
+	else
+	{
+		if (m_last_was_newline == true)
+		{
+			m_text += GetIndent(m_indent_level);
+		}
+	}
+}
+
+// =================================================================
+//	Writes text to the buffer as-is.
+// =================================================================
+void COutputBuffer::Emit(const char* text, int length)
+{
+	BeginText(length > 0 ? text[0] : '\0');
+
+	m_text.append(text, length);
+	m_last_was_newline = (length > 0 && text[length - 1] == '\n');
+}
+
+// =================================================================
+//	Writes text to the buffer as-is.
+// =================================================================
+void COutputBuffer::Emit(const std::string& text)
+{
+	Emit(text.c_str(), (int)text.size());
+}
+
+// =================================================================
+//	Formats text and writes it to the buffer. Indentation is worked
+//	out from the format rather than the text it produces.
+// =================================================================
+void COutputBuffer::EmitFormat(const char* format, va_list& args)
+{
+	int length = (int)strlen(format);
+
+	BeginText(length > 0 ? format[0] : '\0');
+
+	va_list start_list;
+
+// Fucking microsoft.
+#ifdef _WIN32
+	start_list = args;
+#else
+	va_copy(start_list, args);
+#endif
+
+	int size = vsnprintf(&m_format_buffer[0], m_format_buffer.size(), format, args);
+	if (size >= (int)m_format_buffer.size())
+	{
+		m_format_buffer.resize(size + 1);
+		vsnprintf(&m_format_buffer[0], m_format_buffer.size(), format, start_list);
+	}
+	va_end(start_list);
+
+	if (size > 0)
+	{
+		m_text.append(&m_format_buffer[0], size);
+	}
+	m_last_was_newline = (length > 0 && format[length - 1] == '\n');
+}
+
+// =================================================================
+//	Empties the buffer, keeping the memory it has allocated so the
+//	next file can reuse it.
+// =================================================================
+void COutputBuffer::Clear()
+{
+	m_text.clear();
+	m_indent_level = 0;
+	m_last_was_newline = false;
+}
+
+// =================================================================
+//	Swaps the contents of this buffer with another.
+// =================================================================
+void COutputBuffer::Swap(COutputBuffer& other)
+{
+	m_text.swap(other.m_text);
+	std::swap(m_indent_level, other.m_indent_level);
+	std::swap(m_last_was_newline, other.m_last_was_newline);
+}
+
+// =================================================================
+//	Gets the text that has been written to the buffer.
+// =================================================================
+const std::string& COutputBuffer::GetText()
+{
+	return m_text;
+}
+
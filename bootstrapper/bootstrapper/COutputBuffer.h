@@ -0,0 +1,51 @@
+/* *****************************************************************
+
+		COutputBuffer.h
+
+		Copyright (C) 2012 Tim Leonard - All Rights Reserved
+
+   ***************************************************************** */
+#pragma once
+#ifndef _COUTPUTBUFFER_H_
+#define _COUTPUTBUFFER_H_
+
+#include <string>
+#include <vector>
+#include <stdarg.h>
+
+// Initial capacity reserved for a buffer, enough for most translated files.
+#define OUTPUT_BUFFER_RESERVE	(64 * 1024)
+
+// =================================================================
+//	Accumulates the text of a generated file. Indentation follows
+//	the braces written to it, indent strings are cached so plain
+//	text can be appended without any temporary allocations.
+// =================================================================
+class COutputBuffer
+{
+private:
+	std::string					m_text;
+	int							m_indent_level;
+	bool						m_last_was_newline;
+
+	std::vector<std::string>	m_indents;
+	std::vector<char>			m_format_buffer;
+
+	void				BeginText			(char first);
+	const std::string&	GetIndent			(int level);
+
+public:
+	COutputBuffer();
+
+	void				Emit				(const char* text, int length);
+	void				Emit				(const std::string& text);
+	void				EmitFormat			(const char* format, va_list& args);
+
+	void				Clear				();
+	void				Swap				(COutputBuffer& other);
+	const std::string&	GetText				();
+
+};
+
+#endif
+
@@ -172,6 +172,14 @@ CASTNode* CPreFixExpressionASTNode::Semant(CSemanter* semanter)
 		}
 	}
 
+	// Fold constant expressions.
+	if (Token.Type != TokenIdentifier::OP_INCREMENT &&
+		Token.Type != TokenIdentifier::OP_DECREMENT &&
+		semanter->IsConstant(LeftValue))
+	{
+		return semanter->FoldConstant(this);
+	}
+
 	return this;
 }
 
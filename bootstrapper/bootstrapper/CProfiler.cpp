@@ -0,0 +1,372 @@
+/* *****************************************************************
+
+		CProfiler.cpp
+
+		Copyright (C) 2012 Tim Leonard - All Rights Reserved
+
+   ***************************************************************** */
+
+#include "CProfiler.h"
+#include "CStringHelper.h"
+#include "CPathHelper.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <ctime>
+#include <new>
+#include <map>
+#include <algorithm>
+
+#ifdef _WIN32
+#include <Windows.h>
+#elif defined(__linux__) || defined(__APPLE__)
+#include <sys/time.h>
+#endif
+
+// Number of heap allocations made by the compiler so far, bumped by
+// the global operator new replacements below.
+static long long g_allocation_count = 0;
+
+// =================================================================
+//	Global allocation hooks, these just count allocations so the
+//	profiler can attribute them to each phase.
+// =================================================================
+void* operator new(size_t size)
+{
+	g_allocation_count++;
+
+	void* ptr = malloc(size == 0 ? 1 : size);
+	if (ptr == NULL)
+	{
+		throw std::bad_alloc();
+	}
+	return ptr;
+}
+
+void* operator new[](size_t size)
+{
+	g_allocation_count++;
+
+	void* ptr = malloc(size == 0 ? 1 : size);
+	if (ptr == NULL)
+	{
+		throw std::bad_alloc();
+	}
+	return ptr;
+}
+
+void operator delete(void* ptr) throw()
+{
+	free(ptr);
+}
+
+void operator delete[](void* ptr) throw()
+{
+	free(ptr);
+}
+
+// =================================================================
+//	Used to sort summary rows by time spent, slowest first.
+// =================================================================
+struct CProfileSummaryRow
+{
+public:
+	std::string	Name;
+	long long	WallDuration;
+	long long	CPUDuration;
+	long long	Allocations;
+
+	CProfileSummaryRow()
+	{
+		WallDuration = 0;
+		CPUDuration = 0;
+		Allocations = 0;
+	}
+
+	static bool Compare(const CProfileSummaryRow& a, const CProfileSummaryRow& b)
+	{
+		return a.WallDuration > b.WallDuration;
+	}
+};
+
+// =================================================================
+//	Accumulates an events self time into a summary row.
+// =================================================================
+static void AccumulateSummaryRow(std::map<std::string, CProfileSummaryRow>& rows, const std::string& name, const CProfileEvent& evt)
+{
+	CProfileSummaryRow& row = rows[name];
+	row.Name			= name;
+	row.WallDuration	+= evt.SelfWallDuration;
+	row.CPUDuration		+= evt.SelfCPUDuration;
+	row.Allocations		+= evt.SelfAllocations;
+}
+
+// =================================================================
+//	Prints the slowest rows in the given set.
+// =================================================================
+static void PrintSummaryRows(std::string title, std::map<std::string, CProfileSummaryRow>& rows, unsigned int limit)
+{
+	std::vector<CProfileSummaryRow> sorted;
+	for (std::map<std::string, CProfileSummaryRow>::iterator iter = rows.begin(); iter != rows.end(); iter++)
+	{
+		sorted.push_back(iter->second);
+	}
+	std::sort(sorted.begin(), sorted.end(), CProfileSummaryRow::Compare);
+
+	printf("\n%s\n", title.c_str());
+	printf("  %-40s %12s %12s %12s\n", "Name", "Wall (ms)", "CPU (ms)", "Allocations");
+	for (unsigned int i = 0; i < sorted.size() && i < limit; i++)
+	{
+		CProfileSummaryRow& row = sorted.at(i);
+		printf("  %-40s %12.1f %12.1f %12lld\n", row.Name.c_str(), row.WallDuration / 1000.0, row.CPUDuration / 1000.0, row.Allocations);
+	}
+}
+
+// =================================================================
+//	Constructs a new instance of this class.
+// =================================================================
+CProfiler::CProfiler()
+{
+	m_enabled	= false;
+	m_wall_base = GetWallTime();
+}
+
+// =================================================================
+//	Gets the current wall clock time in microseconds.
+// =================================================================
+long long CProfiler::GetWallTime()
+{
+#ifdef _WIN32
+	LARGE_INTEGER frequency;
+	LARGE_INTEGER counter;
+	QueryPerformanceFrequency(&frequency);
+	QueryPerformanceCounter(&counter);
+	return (counter.QuadPart * 1000000) / frequency.QuadPart;
+#elif defined(__linux__) || defined(__APPLE__)
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return ((long long)tv.tv_sec * 1000000) + tv.tv_usec;
+#else
+	return 0;
+#endif
+}
+
+// =================================================================
+//	Gets the processor time used by the process in microseconds.
+// =================================================================
+long long CProfiler::GetCPUTime()
+{
+	return ((long long)clock() * 1000000) / CLOCKS_PER_SEC;
+}
+
+// =================================================================
+//	Gets the number of heap allocations made so far.
+// =================================================================
+long long CProfiler::GetAllocationCount()
+{
+	return g_allocation_count;
+}
+
+// =================================================================
+//	Enables or disables recording of events.
+// =================================================================
+void CProfiler::SetEnabled(bool enabled)
+{
+	m_enabled = enabled;
+	m_wall_base = GetWallTime();
+}
+
+// =================================================================
+//	Returns true if events are being recorded.
+// =================================================================
+bool CProfiler::IsEnabled()
+{
+	return m_enabled;
+}
+
+// =================================================================
+//	Starts recording a new event. Name should be the class the
+//	event applies to, or blank if it applies to the whole unit.
+// =================================================================
+void CProfiler::Begin(const std::string& category, const std::string& name, const std::string& unit)
+{
+	if (m_enabled == false)
+	{
+		return;
+	}
+
+	CProfileEvent evt;
+	evt.Category			= category;
+	evt.Name				= name;
+	evt.Unit				= unit;
+	evt.Depth				= m_stack.size();
+	evt.WallDuration		= 0;
+	evt.SelfWallDuration	= 0;
+	evt.CPUDuration			= 0;
+	evt.SelfCPUDuration		= 0;
+	evt.Allocations			= 0;
+	evt.SelfAllocations		= 0;
+	evt.ChildWallDuration	= 0;
+	evt.ChildCPUDuration	= 0;
+	evt.ChildAllocations	= 0;
+	evt.AllocationStart		= GetAllocationCount();
+	evt.CPUStart			= GetCPUTime();
+	evt.WallStart			= GetWallTime();
+
+	m_stack.push_back(m_events.size());
+	m_events.push_back(evt);
+}
+
+// =================================================================
+//	Finishes recording the last event begun.
+// =================================================================
+void CProfiler::End()
+{
+	if (m_enabled == false || m_stack.size() == 0)
+	{
+		return;
+	}
+
+	long long wall_end	= GetWallTime();
+	long long cpu_end	= GetCPUTime();
+	long long alloc_end	= GetAllocationCount();
+
+	CProfileEvent& evt = m_events.at(m_stack.back());
+	m_stack.pop_back();
+
+	evt.WallDuration		= wall_end - evt.WallStart;
+	evt.SelfWallDuration	= evt.WallDuration - evt.ChildWallDuration;
+	evt.CPUDuration			= cpu_end - evt.CPUStart;
+	evt.SelfCPUDuration		= evt.CPUDuration - evt.ChildCPUDuration;
+	evt.Allocations			= alloc_end - evt.AllocationStart;
+	evt.SelfAllocations		= evt.Allocations - evt.ChildAllocations;
+
+	if (m_stack.size() > 0)
+	{
+		CProfileEvent& parent = m_events.at(m_stack.back());
+		parent.ChildWallDuration	+= evt.WallDuration;
+		parent.ChildCPUDuration		+= evt.CPUDuration;
+		parent.ChildAllocations		+= evt.Allocations;
+	}
+}
+
+// =================================================================
+//	Escapes a string so it can be embedded in a JSON document.
+// =================================================================
+std::string CProfiler::EscapeJSON(const std::string& value)
+{
+	std::string result = "";
+	result.reserve(value.size());
+
+	for (unsigned int i = 0; i < value.size(); i++)
+	{
+		char chr = value.at(i);
+		switch (chr)
+		{
+			case '"':	result += "\\\"";	break;
+			case '\\':	result += "\\\\";	break;
+			case '\n':	result += "\\n";	break;
+			case '\r':	result += "\\r";	break;
+			case '\t':	result += "\\t";	break;
+			default:
+				{
+					if ((unsigned char)chr < 0x20)
+					{
+						result += CStringHelper::FormatString("\\u%04x", (int)chr);
+					}
+					else
+					{
+						result += chr;
+					}
+					break;
+				}
+		}
+	}
+
+	return result;
+}
+
+// =================================================================
+//	Writes all recorded events out in chrome's trace_event format.
+// =================================================================
+bool CProfiler::WriteTrace(std::string path)
+{
+	std::string output = "{\"traceEvents\":[\n";
+
+	for (unsigned int i = 0; i < m_events.size(); i++)
+	{
+		CProfileEvent& evt = m_events.at(i);
+		std::string name = evt.Name == "" ? evt.Category + " " + evt.Unit : evt.Name;
+
+		output += CStringHelper::FormatString("{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%lld,\"dur\":%lld,\"pid\":1,\"tid\":1,",
+											  EscapeJSON(name).c_str(),
+											  EscapeJSON(evt.Category).c_str(),
+											  evt.WallStart - m_wall_base,
+											  evt.WallDuration);
+		output += CStringHelper::FormatString("\"args\":{\"unit\":\"%s\",\"self_us\":%lld,\"cpu_us\":%lld,\"allocations\":%lld}}",
+											  EscapeJSON(evt.Unit).c_str(),
+											  evt.SelfWallDuration,
+											  evt.CPUDuration,
+											  evt.Allocations);
+		output += (i < m_events.size() - 1) ? ",\n" : "\n";
+	}
+
+	output += "]}\n";
+
+	return CPathHelper::SaveFile(path, output);
+}
+
+// =================================================================
+//	Prints a summary of where time was spent, slowest first.
+//	Times are exclusive of any nested events.
+// =================================================================
+void CProfiler::PrintSummary()
+{
+	std::map<std::string, CProfileSummaryRow> phases;
+	std::map<std::string, CProfileSummaryRow> units;
+	std::map<std::string, CProfileSummaryRow> classes;
+
+	for (std::vector<CProfileEvent>::iterator iter = m_events.begin(); iter != m_events.end(); iter++)
+	{
+		CProfileEvent& evt = *iter;
+
+		AccumulateSummaryRow(phases, evt.Category, evt);
+		AccumulateSummaryRow(units, evt.Unit, evt);
+
+		if (evt.Name != "")
+		{
+			AccumulateSummaryRow(classes, evt.Name, evt);
+		}
+	}
+
+	printf("\n=============================================================\n");
+	printf(" Profile Summary\n");
+	printf("=============================================================\n");
+	PrintSummaryRows("Phases:", phases, phases.size());
+	PrintSummaryRows("Slowest Units:", units, 15);
+	PrintSummaryRows("Slowest Classes:", classes, 15);
+	printf("\n");
+}
+
+// =================================================================
+//	Begins profiling a new scope.
+// =================================================================
+CProfileScope::CProfileScope(CProfiler* profiler, const char* category, const std::string& name, const std::string& unit)
+{
+	m_profiler = (profiler != NULL && profiler->IsEnabled()) ? profiler : NULL;
+	if (m_profiler != NULL)
+	{
+		m_profiler->Begin(category, name, CPathHelper::StripDirectory(unit));
+	}
+}
+
+// =================================================================
+//	Finishes profiling the scope.
+// =================================================================
+CProfileScope::~CProfileScope()
+{
+	if (m_profiler != NULL)
+	{
+		m_profiler->End();
+	}
+}
@@ -0,0 +1,91 @@
+/* *****************************************************************
+
+		CProfiler.h
+
+		Copyright (C) 2012 Tim Leonard - All Rights Reserved
+
+   ***************************************************************** */
+#pragma once
+#ifndef _CPROFILER_H_
+#define _CPROFILER_H_
+
+#include <string>
+#include <vector>
+
+// =================================================================
+//	Stores timing information on a single profiled scope.
+//	Times are in microseconds.
+// =================================================================
+struct CProfileEvent
+{
+public:
+	std::string		Name;
+	std::string		Category;
+	std::string		Unit;
+
+	long long		WallStart;
+	long long		WallDuration;
+	long long		SelfWallDuration;
+	long long		CPUStart;
+	long long		CPUDuration;
+	long long		SelfCPUDuration;
+	long long		AllocationStart;
+	long long		Allocations;
+	long long		SelfAllocations;
+
+	long long		ChildWallDuration;
+	long long		ChildCPUDuration;
+	long long		ChildAllocations;
+
+	int				Depth;
+};
+
+// =================================================================
+//	Records the time spent in each phase of the compile, and which
+//	units and classes that time was spent on. Output can be viewed
+//	in chrome://tracing.
+// =================================================================
+class CProfiler
+{
+private:
+	bool						m_enabled;
+	long long					m_wall_base;
+	std::vector<CProfileEvent>	m_events;
+	std::vector<int>			m_stack;
+
+	std::string EscapeJSON		(const std::string& value);
+
+public:
+	CProfiler();
+
+	static long long GetWallTime		();
+	static long long GetCPUTime			();
+	static long long GetAllocationCount	();
+
+	void		SetEnabled				(bool enabled);
+	bool		IsEnabled				();
+
+	void		Begin					(const std::string& category, const std::string& name, const std::string& unit);
+	void		End						();
+
+	bool		WriteTrace				(std::string path);
+	void		PrintSummary			();
+
+};
+
+// =================================================================
+//	Profiles the lifetime of the scope it is declared in. Does
+//	nothing if the profiler is NULL or disabled.
+// =================================================================
+class CProfileScope
+{
+private:
+	CProfiler*	m_profiler;
+
+public:
+	CProfileScope(CProfiler* profiler, const char* category, const std::string& name, const std::string& unit);
+	~CProfileScope();
+
+};
+
+#endif
@@ -0,0 +1,503 @@
+/* *****************************************************************
+
+		CPruner.cpp
+
+		Copyright (C) 2012 Tim Leonard - All Rights Reserved
+
+   ***************************************************************** */
+
+#include <string>
+#include <stdio.h>
+
+#include "CCompiler.h"
+#include "CPruner.h"
+#include "CSemanter.h"
+#include "CStringHelper.h"
+#include "CPathHelper.h"
+#include "CProfiler.h"
+#include "CTranslationUnit.h"
+
+#include "CASTNode.h"
+#include "CClassASTNode.h"
+#include "CClassBodyASTNode.h"
+#include "CClassMemberASTNode.h"
+#include "CMethodBodyASTNode.h"
+#include "CVariableStatementASTNode.h"
+#include "CExpressionASTNode.h"
+#include "CExpressionBaseASTNode.h"
+#include "CCastExpressionASTNode.h"
+#include "CComparisonExpressionASTNode.h"
+#include "CIdentifierExpressionASTNode.h"
+#include "CMethodCallExpressionASTNode.h"
+#include "CNewExpressionASTNode.h"
+#include "CTypeExpressionASTNode.h"
+
+#include "CDataType.h"
+#include "CArrayDataType.h"
+#include "CBoolDataType.h"
+#include "CFloatDataType.h"
+#include "CIntDataType.h"
+#include "CObjectDataType.h"
+#include "CStringDataType.h"
+#include "CClassReferenceDataType.h"
+
+// =================================================================
+//	Constructs a new instance of this class.
+// =================================================================
+CPruner::CPruner()
+{
+	m_context	= NULL;
+	m_semanter	= NULL;
+}
+
+// =================================================================
+//	Marks everything reachable from the entry point, everything
+//	else is flagged as unreachable and skipped by the translator.
+// =================================================================
+bool CPruner::Process(CTranslationUnit* context)
+{
+	CProfileScope scope(context->GetCompiler()->GetProfiler(), "prune", "", context->GetFilePath());
+
+	m_context	= context;
+	m_semanter	= context->GetSemanter();
+
+	m_classes.clear();
+	m_methods.clear();
+	m_method_worklist.clear();
+	m_virtual_identifiers.clear();
+	m_live_virtual_identifiers.clear();
+	m_virtual_methods.clear();
+	m_primitive_classes.clear();
+	m_native_identifiers.clear();
+
+	// Find every class that will be translated, generic classes are
+	// only ever translated through their instances.
+	std::vector<CASTNode*>& children = context->GetASTRoot()->Children;
+	for (std::vector<CASTNode*>::iterator iter = children.begin(); iter != children.end(); iter++)
+	{
+		CClassASTNode* classNode = dynamic_cast<CClassASTNode*>(*iter);
+		if (classNode == NULL)
+		{
+			continue;
+		}
+		if (classNode->IsGeneric == true)
+		{
+			for (std::vector<CClassASTNode*>::iterator iter2 = classNode->GenericInstances.begin(); iter2 != classNode->GenericInstances.end(); iter2++)
+			{
+				CollectClass(*iter2);
+			}
+		}
+		else
+		{
+			CollectClass(classNode);
+		}
+	}
+
+	// Overrides and interface implementations share the mangled identifier of
+	// the method they override, so group them by it. If one of them is reachable
+	// then any of the others may be called through it.
+	for (std::vector<CClassMemberASTNode*>::iterator iter = m_methods.begin(); iter != m_methods.end(); iter++)
+	{
+		CClassMemberASTNode* member = *iter;
+		if (IsVirtualMethod(member))
+		{
+			m_virtual_methods[member->MangledIdentifier].push_back(member);
+		}
+	}
+
+	// Native code can call straight into translated code, so anything it
+	// refers to by its mangled identifier has to be kept.
+	std::vector<std::string> native_files = context->GetNativeFileList();
+	for (std::vector<std::string>::iterator iter = native_files.begin(); iter != native_files.end(); iter++)
+	{
+		std::string file_no_extension = CPathHelper::StripExtension(*iter);
+
+		CollectNativeFile(file_no_extension + ".hpp");
+		CollectNativeFile(file_no_extension + ".h");
+		CollectNativeFile(file_no_extension + ".cpp");
+		CollectNativeFile(file_no_extension + ".c");
+		CollectNativeFile(file_no_extension + ".cc");
+		CollectNativeFile(file_no_extension + ".cxx");
+	}
+
+	for (std::vector<CClassASTNode*>::iterator iter = m_classes.begin(); iter != m_classes.end(); iter++)
+	{
+		if (m_native_identifiers.find((*iter)->MangledIdentifier) != m_native_identifiers.end())
+		{
+			MarkClass(*iter);
+		}
+	}
+	for (std::vector<CClassMemberASTNode*>::iterator iter = m_methods.begin(); iter != m_methods.end(); iter++)
+	{
+		if (m_native_identifiers.find((*iter)->MangledIdentifier) != m_native_identifiers.end())
+		{
+			MarkMethod(*iter);
+		}
+	}
+
+	// Mark everything reachable from the entry point.
+	MarkMethod(context->GetEntryPoint());
+
+	while (m_method_worklist.size() > 0)
+	{
+		CClassMemberASTNode* member = m_method_worklist.back();
+		m_method_worklist.pop_back();
+
+		MarkDataType(member->ReturnType);
+
+		for (std::vector<CVariableStatementASTNode*>::iterator iter = member->Arguments.begin(); iter != member->Arguments.end(); iter++)
+		{
+			MarkNode(*iter);
+		}
+
+		MarkNode(member->Body);
+	}
+
+	// Let the user know what we got rid of.
+	int pruned_classes = 0;
+	int pruned_methods = 0;
+
+	for (std::vector<CClassASTNode*>::iterator iter = m_classes.begin(); iter != m_classes.end(); iter++)
+	{
+		if ((*iter)->IsReachable == false)
+		{
+			pruned_classes++;
+		}
+	}
+	for (std::vector<CClassMemberASTNode*>::iterator iter = m_methods.begin(); iter != m_methods.end(); iter++)
+	{
+		if ((*iter)->IsReachable == false)
+		{
+			pruned_methods++;
+		}
+	}
+
+	std::string report_path = context->GetCompiler()->GetBuildDirectory() + "pruned.txt";
+	WriteReport(report_path);
+
+	context->Info(CStringHelper::FormatString("Pruned %i of %i classes and %i of %i methods as unreachable, see %s.",
+											  pruned_classes, (int)m_classes.size(),
+											  pruned_methods, (int)m_methods.size(),
+											  report_path.c_str()));
+
+	return true;
+}
+
+// =================================================================
+//	Adds a class and its methods to the set being pruned, they are
+//	all assumed unreachable until marked otherwise.
+// =================================================================
+void CPruner::CollectClass(CClassASTNode* node)
+{
+	node->IsReachable = false;
+	m_classes.push_back(node);
+
+	for (std::vector<CASTNode*>::iterator iter = node->Body->Children.begin(); iter != node->Body->Children.end(); iter++)
+	{
+		CClassMemberASTNode* member = dynamic_cast<CClassMemberASTNode*>(*iter);
+		if (member == NULL)
+		{
+			continue;
+		}
+
+		if (member->MemberType == MemberType::Method)
+		{
+			member->IsReachable = false;
+			m_methods.push_back(member);
+
+			if (member->IsStatic == false &&
+				member->IsExtension == false &&
+				(member->IsVirtual == true || member->IsAbstract == true || node->IsInterface == true))
+			{
+				m_virtual_identifiers.insert(member->MangledIdentifier);
+			}
+		}
+	}
+}
+
+// =================================================================
+//	Adds every identifier used in a native source file to the set
+//	of identifiers native code may reference.
+// =================================================================
+void CPruner::CollectNativeFile(std::string path)
+{
+	std::string source = "";
+	if (!CPathHelper::IsFile(path) ||
+		!CPathHelper::LoadFile(path, source))
+	{
+		return;
+	}
+
+	unsigned int start = 0;
+	bool		 in_identifier = false;
+
+	for (unsigned int i = 0; i <= source.size(); i++)
+	{
+		char chr = i < source.size() ? source.at(i) : '\0';
+		bool is_identifier_char = (chr >= 'a' && chr <= 'z') ||
+								  (chr >= 'A' && chr <= 'Z') ||
+								  (chr >= '0' && chr <= '9') ||
+								  chr == '_';
+
+		if (is_identifier_char == true && in_identifier == false)
+		{
+			start = i;
+			in_identifier = true;
+		}
+		else if (is_identifier_char == false && in_identifier == true)
+		{
+			m_native_identifiers.insert(source.substr(start, i - start));
+			in_identifier = false;
+		}
+	}
+}
+
+// =================================================================
+//	Returns true if the given method can be called through a virtual
+//	or interface method declared elsewhere.
+// =================================================================
+bool CPruner::IsVirtualMethod(CClassMemberASTNode* node)
+{
+	return node->IsStatic == false &&
+		   node->IsExtension == false &&
+		   m_virtual_identifiers.find(node->MangledIdentifier) != m_virtual_identifiers.end();
+}
+
+// =================================================================
+//	Marks a class as reachable, along with everything it needs to
+//	be constructed.
+// =================================================================
+void CPruner::MarkClass(CClassASTNode* node)
+{
+	if (node == NULL ||
+		node->IsReachable == true)
+	{
+		return;
+	}
+
+	node->IsReachable = true;
+
+	MarkClass(node->SuperClass);
+	for (std::vector<CClassASTNode*>::iterator iter = node->Interfaces.begin(); iter != node->Interfaces.end(); iter++)
+	{
+		MarkClass(*iter);
+	}
+
+	if (node->Body == NULL)
+	{
+		return;
+	}
+
+	for (std::vector<CASTNode*>::iterator iter = node->Body->Children.begin(); iter != node->Body->Children.end(); iter++)
+	{
+		CClassMemberASTNode* member = dynamic_cast<CClassMemberASTNode*>(*iter);
+		if (member == NULL)
+		{
+			continue;
+		}
+
+		// Fields are always emitted.
+		if (member->MemberType == MemberType::Field)
+		{
+			MarkDataType(member->ReturnType);
+			MarkNode(member->Assignment);
+		}
+
+		// Constructors, native methods and overrides of methods
+		// already reachable come along with the class.
+		else if (member == node->ClassConstructor ||
+				 member == node->InstanceConstructor ||
+				 member->IsNative == true ||
+				 (IsVirtualMethod(member) && m_live_virtual_identifiers.find(member->MangledIdentifier) != m_live_virtual_identifiers.end()))
+		{
+			MarkMethod(member);
+		}
+	}
+}
+
+// =================================================================
+//	Marks a method as reachable and queues its body to be walked.
+// =================================================================
+void CPruner::MarkMethod(CClassMemberASTNode* node)
+{
+	if (node == NULL ||
+		node->IsReachable == true ||
+		node->IsBodyDeferred == true)
+	{
+		return;
+	}
+
+	node->IsReachable = true;
+	m_method_worklist.push_back(node);
+
+	MarkClass(dynamic_cast<CClassASTNode*>(node->Parent->Parent));
+
+	// Anything overriding this method may now be called through it.
+	if (IsVirtualMethod(node) &&
+		m_live_virtual_identifiers.insert(node->MangledIdentifier).second == true)
+	{
+		std::vector<CClassMemberASTNode*>& overrides = m_virtual_methods[node->MangledIdentifier];
+		for (std::vector<CClassMemberASTNode*>::iterator iter = overrides.begin(); iter != overrides.end(); iter++)
+		{
+			CClassASTNode* classNode = dynamic_cast<CClassASTNode*>((*iter)->Parent->Parent);
+			if (classNode->IsReachable == true)
+			{
+				MarkMethod(*iter);
+			}
+		}
+	}
+}
+
+// =================================================================
+//	Marks the classes a data type is translated to. Primitive types
+//	also mark their box class as casts and type checks use it.
+// =================================================================
+void CPruner::MarkDataType(CDataType* type)
+{
+	if (type == NULL)
+	{
+		return;
+	}
+
+	CArrayDataType* arrayType = dynamic_cast<CArrayDataType*>(type);
+	if (arrayType != NULL)
+	{
+		MarkClass(arrayType->GetClass(m_semanter));
+		MarkDataType(arrayType->ElementType);
+	}
+	else if (dynamic_cast<CObjectDataType*>(type)			!= NULL ||
+			 dynamic_cast<CClassReferenceDataType*>(type)	!= NULL)
+	{
+		MarkClass(type->GetClass(m_semanter));
+	}
+	else if (dynamic_cast<CBoolDataType*>(type)		!= NULL ||
+			 dynamic_cast<CIntDataType*>(type)		!= NULL ||
+			 dynamic_cast<CFloatDataType*>(type)	!= NULL ||
+			 dynamic_cast<CStringDataType*>(type)	!= NULL)
+	{
+		std::string name = type->ToString();
+
+		std::unordered_map<std::string, CClassASTNode*>::iterator iter = m_primitive_classes.find(name);
+		if (iter == m_primitive_classes.end())
+		{
+			m_primitive_classes.insert(std::pair<std::string, CClassASTNode*>(name, type->GetClass(m_semanter)));
+			m_primitive_classes.insert(std::pair<std::string, CClassASTNode*>(name + "#box", type->GetBoxClass(m_semanter)));
+		}
+
+		MarkClass(m_primitive_classes[name]);
+		MarkClass(m_primitive_classes[name + "#box"]);
+	}
+}
+
+// =================================================================
+//	Marks everything referenced by a node and its children.
+// =================================================================
+void CPruner::MarkNode(CASTNode* node)
+{
+	if (node == NULL)
+	{
+		return;
+	}
+
+	// Variable declarations.
+	CVariableStatementASTNode* variableNode = dynamic_cast<CVariableStatementASTNode*>(node);
+	if (variableNode != NULL)
+	{
+		MarkDataType(variableNode->Type);
+	}
+
+	// Expressions.
+	CExpressionBaseASTNode* exprNode = dynamic_cast<CExpressionBaseASTNode*>(node);
+	if (exprNode != NULL)
+	{
+		MarkDataType(exprNode->ExpressionResultType);
+
+		CMethodCallExpressionASTNode* callNode = dynamic_cast<CMethodCallExpressionASTNode*>(node);
+		if (callNode != NULL)
+		{
+			MarkMethod(dynamic_cast<CClassMemberASTNode*>(callNode->ResolvedDeclaration));
+		}
+
+		CIdentifierExpressionASTNode* identNode = dynamic_cast<CIdentifierExpressionASTNode*>(node);
+		if (identNode != NULL)
+		{
+			CClassMemberASTNode* member = dynamic_cast<CClassMemberASTNode*>(identNode->ResolvedDeclaration);
+			if (member != NULL)
+			{
+				if (member->MemberType == MemberType::Method)
+				{
+					MarkMethod(member);
+				}
+				else
+				{
+					MarkClass(dynamic_cast<CClassASTNode*>(member->Parent->Parent));
+				}
+			}
+			else
+			{
+				MarkClass(dynamic_cast<CClassASTNode*>(identNode->ResolvedDeclaration));
+			}
+		}
+
+		CNewExpressionASTNode* newNode = dynamic_cast<CNewExpressionASTNode*>(node);
+		if (newNode != NULL)
+		{
+			MarkDataType(newNode->DataType);
+			MarkMethod(newNode->ResolvedConstructor);
+		}
+
+		CCastExpressionASTNode* castNode = dynamic_cast<CCastExpressionASTNode*>(node);
+		if (castNode != NULL)
+		{
+			MarkDataType(castNode->Type);
+		}
+
+		CTypeExpressionASTNode* typeNode = dynamic_cast<CTypeExpressionASTNode*>(node);
+		if (typeNode != NULL)
+		{
+			MarkDataType(typeNode->Type);
+		}
+
+		CComparisonExpressionASTNode* compareNode = dynamic_cast<CComparisonExpressionASTNode*>(node);
+		if (compareNode != NULL)
+		{
+			MarkDataType(compareNode->CompareResultType);
+		}
+	}
+
+	for (std::vector<CASTNode*>::iterator iter = node->Children.begin(); iter != node->Children.end(); iter++)
+	{
+		MarkNode(*iter);
+	}
+}
+
+// =================================================================
+//	Writes out a list of every class and method that was pruned.
+// =================================================================
+bool CPruner::WriteReport(std::string path)
+{
+	std::string output = "";
+
+	output += "Pruned Classes:\n";
+	for (std::vector<CClassASTNode*>::iterator iter = m_classes.begin(); iter != m_classes.end(); iter++)
+	{
+		if ((*iter)->IsReachable == false)
+		{
+			output += "\t" + (*iter)->ToString() + "\n";
+		}
+	}
+
+	output += "\nPruned Methods:\n";
+	for (std::vector<CClassMemberASTNode*>::iterator iter = m_methods.begin(); iter != m_methods.end(); iter++)
+	{
+		CClassMemberASTNode* member = *iter;
+		CClassASTNode*		 classNode = dynamic_cast<CClassASTNode*>(member->Parent->Parent);
+
+		if (member->IsReachable == false && classNode->IsReachable == true)
+		{
+			output += "\t" + classNode->ToString() + ": " + member->ToString() + "\n";
+		}
+	}
+
+	return CPathHelper::SaveFile(path, output);
+}
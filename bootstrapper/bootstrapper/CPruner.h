@@ -0,0 +1,66 @@
+/* *****************************************************************
+
+		CPruner.h
+
+		Copyright (C) 2012 Tim Leonard - All Rights Reserved
+
+   ***************************************************************** */
+#pragma once
+#ifndef _CPRUNER_H_
+#define _CPRUNER_H_
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+
+class CTranslationUnit;
+class CSemanter;
+class CDataType;
+class CASTNode;
+class CClassASTNode;
+class CClassMemberASTNode;
+
+// =================================================================
+//	Works out which classes and methods can be reached from the
+//	programs entry point once semantic analysis is complete. Anything
+//	that can't be reached is flagged so the translator can skip it.
+// =================================================================
+class CPruner
+{
+private:
+	CTranslationUnit*									m_context;
+	CSemanter*											m_semanter;
+
+	std::vector<CClassASTNode*>							m_classes;
+	std::vector<CClassMemberASTNode*>					m_methods;
+
+	std::vector<CClassMemberASTNode*>					m_method_worklist;
+
+	std::unordered_set<std::string>						m_virtual_identifiers;
+	std::unordered_set<std::string>						m_live_virtual_identifiers;
+	std::unordered_map<std::string, std::vector<CClassMemberASTNode*> > m_virtual_methods;
+
+	std::unordered_map<std::string, CClassASTNode*>		m_primitive_classes;
+
+	std::unordered_set<std::string>						m_native_identifiers;
+
+	void CollectClass			(CClassASTNode* node);
+	void CollectNativeFile		(std::string path);
+	bool IsVirtualMethod		(CClassMemberASTNode* node);
+
+	void MarkClass				(CClassASTNode* node);
+	void MarkMethod				(CClassMemberASTNode* node);
+	void MarkDataType			(CDataType* type);
+	void MarkNode				(CASTNode* node);
+
+	bool WriteReport			(std::string path);
+
+public:
+	CPruner();
+
+	bool Process				(CTranslationUnit* context);
+
+};
+
+#endif
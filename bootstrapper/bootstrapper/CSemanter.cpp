@@ -9,6 +9,8 @@
 #include <string>
 #include <stdio.h>
 #include <assert.h>
+#include <limits.h>
+#include <float.h>
 
 #include "CCompiler.h"
 #include "CSemanter.h"
@@ -18,13 +20,18 @@
 #include "CASTNode.h"
 #include "CDeclarationASTNode.h"
 #include "CTranslationUnit.h"
+#include "CProfiler.h"
 #include "CClassASTNode.h"
+#include "CClassBodyASTNode.h"
 #include "CPackageASTNode.h"
 #include "CAliasASTNode.h"
 #include "CClassMemberASTNode.h"
 #include "CLiteralExpressionASTNode.h"
 #include "CExpressionASTNode.h"
 #include "CExpressionBaseASTNode.h"
+#include "CBlockStatementASTNode.h"
+#include "CIdentifierExpressionASTNode.h"
+#include "CFieldAccessExpressionASTNode.h"
 
 #include "CDataType.h"
 #include "CObjectDataType.h"
@@ -33,6 +40,7 @@
 #include "CFloatDataType.h"
 #include "CNullDataType.h"
 #include "CBoolDataType.h"
+#include "CClassReferenceDataType.h"
 
 // Global variable used for log tracing.
 #ifndef _NDEBUG
@@ -46,15 +54,61 @@ bool CSemanter::Process(CTranslationUnit* context)
 {	
 	m_context = context;
 	m_internal_var_counter = 0;
+	m_folded_expressions = 0;
+	m_folded_branches = 0;
 	
 	//context->Info("Semantic Analysis ...");
 //	context->GetASTRoot()->Prepare(this);
 
+	CProfiler* profiler = context->GetCompiler()->GetProfiler();
+
 	//context->Info("Semantic Analysis ...");
-	context->GetASTRoot()->Semant(this);
+	{
+		CProfileScope scope(profiler, "semant", "", context->GetFilePath());
+		context->GetASTRoot()->Semant(this);
+	}
 
 	//context->Info("Semantic Finalization ...");
-	context->GetASTRoot()->Finalize(this);
+	{
+		CProfileScope scope(profiler, "finalize", "", context->GetFilePath());
+		context->GetASTRoot()->Finalize(this);
+	}
+
+	// Let the user know how many generic methods were never instanced.
+	int generic_methods  = 0;
+	int deferred_methods = 0;
+
+	std::vector<CASTNode*>& children = context->GetASTRoot()->Children;
+	for (std::vector<CASTNode*>::iterator iter = children.begin(); iter != children.end(); iter++)
+	{
+		CClassASTNode* classNode = dynamic_cast<CClassASTNode*>(*iter);
+		if (classNode == NULL)
+		{
+			continue;
+		}
+
+		for (std::vector<CClassASTNode*>::iterator iter2 = classNode->GenericInstances.begin(); iter2 != classNode->GenericInstances.end(); iter2++)
+		{
+			CClassASTNode* instance = *iter2;
+			for (std::vector<CASTNode*>::iterator iter3 = instance->Body->Children.begin(); iter3 != instance->Body->Children.end(); iter3++)
+			{
+				CClassMemberASTNode* member = dynamic_cast<CClassMemberASTNode*>(*iter3);
+				if (member != NULL && member->MemberType == MemberType::Method)
+				{
+					generic_methods++;
+					if (member->IsBodyDeferred == true)
+					{
+						deferred_methods++;
+					}
+				}
+			}
+		}
+	}
+
+	if (generic_methods > 0)
+	{
+		context->Info(CStringHelper::FormatString("Skipped semantic analysis of %i of %i generic instance methods.", deferred_methods, generic_methods));
+	}
 
 	return true;
 }
@@ -104,35 +158,32 @@ CExpressionASTNode*	CSemanter::ConstructDefaultAssignmentExpr(CASTNode* parent,
 }
 
 // =================================================================
-//	Gets a unique mangled identifier.
+//	Gets a unique mangled identifier. If the identifier is taken
+//	the first free of _1, _2, ... is appended. Suffixes below the
+//	next-suffix counter for a name are known to be taken, so we
+//	can start searching from there.
 // =================================================================
 std::string	CSemanter::GetMangled(std::string mangled)
 {
-	std::string originalMangled = mangled;
-
-	int index = 1;
-	while (true)
+	if (m_mangled.insert(mangled).second == true)
 	{
-		bool found = false;
+		return mangled;
+	}
 
-		for (std::vector<std::string>::iterator  iter = m_mangled.begin(); iter != m_mangled.end(); iter++)
-		{
-			if (*iter == mangled)
-			{
-				mangled = originalMangled + "_" + CStringHelper::ToString(index++);
-				found = true;
-				break;
-			}
-		}
+	int& index = m_mangled_next_suffix[mangled];
+	if (index == 0)
+	{
+		index = 1;
+	}
 
-		if (found == false)
+	while (true)
+	{
+		std::string candidate = mangled + "_" + CStringHelper::ToString(index++);
+		if (m_mangled.insert(candidate).second == true)
 		{
-			break;
+			return candidate;
 		}
 	}
-	m_mangled.push_back(mangled);
-	
-	return mangled;
 }
 
 // =================================================================
@@ -195,4 +246,183 @@ CDataType* CSemanter::BalanceDataTypes(CDataType* lvalue, CDataType* rvalue)
 	m_context->FatalError(CStringHelper::FormatString("Unable to implicitly convert between data-types '%s' and '%s'", lvalue->ToString().c_str(), rvalue->ToString().c_str()), lvalue->Token);
 
 	return NULL;
+}
+
+// =================================================================
+//	Returns true if the given expression has a value that is known
+//	at compile time. This is either a literal or a const field that
+//	is initialized with a literal.
+// =================================================================
+bool CSemanter::IsConstant(CASTNode* node)
+{
+	if (m_context->GetCompiler()->GetFoldConstants() == false)
+	{
+		return false;
+	}
+
+	// Look through the statement wrapper around conditions.
+	CExpressionASTNode* wrapper = dynamic_cast<CExpressionASTNode*>(node);
+	if (wrapper != NULL)
+	{
+		return IsConstant(wrapper->LeftValue);
+	}
+
+	CExpressionBaseASTNode* expr = dynamic_cast<CExpressionBaseASTNode*>(node);
+	if (expr == NULL)
+	{
+		return false;
+	}
+
+	CLiteralExpressionASTNode* literal = dynamic_cast<CLiteralExpressionASTNode*>(node);
+	if (literal == NULL)
+	{
+		// Const fields accessed through an instance still evaluate the instance.
+		CClassMemberASTNode*		   field	  = NULL;
+		CIdentifierExpressionASTNode*  identifier = dynamic_cast<CIdentifierExpressionASTNode*>(node);
+		CFieldAccessExpressionASTNode* access	  = dynamic_cast<CFieldAccessExpressionASTNode*>(node);
+
+		if (identifier != NULL)
+		{
+			field = identifier->ExpressionResultClassMember;
+		}
+		else if (access != NULL &&
+				 dynamic_cast<CClassReferenceDataType*>(dynamic_cast<CExpressionBaseASTNode*>(access->LeftValue)->ExpressionResultType) != NULL)
+		{
+			field = access->ExpressionResultClassMember;
+		}
+
+		if (field == NULL ||
+			field->MemberType != MemberType::Field ||
+			field->IsConst == false ||
+			field->IsStatic == false ||
+			field->IsNative == true)
+		{
+			return false;
+		}
+
+		if (field->Assignment != NULL)
+		{
+			literal = dynamic_cast<CLiteralExpressionASTNode*>(field->Assignment->LeftValue);
+		}
+		if (literal == NULL)
+		{
+			return false;
+		}
+		literal->Semant(this);
+	}
+
+	// Int literals that can't be read back exactly, such as ones that are
+	// out of range, are left for the C++ compiler to deal with.
+	int value = 0;
+	if (dynamic_cast<CIntDataType*>(literal->ExpressionResultType) != NULL &&
+		CStringHelper::TryToInt(literal->Literal, value) == false)
+	{
+		return false;
+	}
+
+	CDataType* type = expr->ExpressionResultType;
+	return (dynamic_cast<CBoolDataType*>(type)	 != NULL ||
+			dynamic_cast<CIntDataType*>(type)	 != NULL ||
+			dynamic_cast<CFloatDataType*>(type)	 != NULL ||
+			dynamic_cast<CStringDataType*>(type) != NULL) &&
+		   literal->ExpressionResultType->IsEqualTo(this, type);
+}
+
+// =================================================================
+//	Evaluates an expression whose operands are all constant and 
+//	returns a literal to replace it with.
+// =================================================================
+CASTNode* CSemanter::FoldConstant(CExpressionBaseASTNode* node)
+{
+	return FoldConstant(node, node->Evaluate(m_context));
+}
+
+// =================================================================
+//	Returns a literal with the given value to replace an expression
+//	with. If the value can't be represented as a literal the 
+//	expression is returned unchanged.
+// =================================================================
+CASTNode* CSemanter::FoldConstant(CExpressionBaseASTNode* node, EvaluationResult result)
+{
+	CDataType*	type	= node->ExpressionResultType;
+	std::string literal = "";
+
+	if (dynamic_cast<CBoolDataType*>(type) != NULL)
+	{
+		literal = result.GetBool() ? "true" : "false";
+	}
+	else if (dynamic_cast<CIntDataType*>(type) != NULL)
+	{
+		// -2147483648 isn't an int literal in C++.
+		if (result.GetInt() == INT_MIN)
+		{
+			return node;
+		}
+		literal = CStringHelper::ToString(result.GetInt());
+	}
+	else if (dynamic_cast<CFloatDataType*>(type) != NULL)
+	{
+		float value = result.GetFloat();
+		if (value != value || value > FLT_MAX || value < -FLT_MAX)
+		{
+			return node;
+		}
+
+		literal = CStringHelper::FormatString("%.9g", value);
+		if (literal.find_first_of(".e") == std::string::npos)
+		{
+			literal += ".0";
+		}
+	}
+	else if (dynamic_cast<CStringDataType*>(type) != NULL)
+	{
+		literal = result.GetString();
+	}
+	else
+	{
+		return node;
+	}
+
+	CLiteralExpressionASTNode* lit = new CLiteralExpressionASTNode(NULL, node->Token, type, literal);
+	lit->Semant(this);
+
+	m_folded_expressions++;
+
+	return lit;
+}
+
+// =================================================================
+//	Replaces a statement whose condition is constant with the branch
+//	that will always be taken. A block is used so any variables
+//	declared in the branch keep their scope.
+// =================================================================
+CASTNode* CSemanter::FoldBranch(CASTNode* node, CASTNode* branch)
+{
+	CBlockStatementASTNode* block = new CBlockStatementASTNode(NULL, node->Token);
+
+	if (branch != NULL)
+	{
+		block->AddChild(branch);
+	}
+
+	m_folded_branches++;
+
+	return block;
+}
+
+// =================================================================
+//	Gets the number of expressions folded into literals.
+// =================================================================
+int CSemanter::GetFoldedExpressions()
+{
+	return m_folded_expressions;
+}
+
+// =================================================================
+//	Gets the number of branches removed because their conditions
+//	were constant.
+// =================================================================
+int CSemanter::GetFoldedBranches()
+{
+	return m_folded_branches;
 }
\ No newline at end of file
@@ -9,7 +9,11 @@
 #ifndef _CSEMANTER_H_
 #define _CSEMANTER_H_
 
+#include <unordered_map>
+#include <unordered_set>
+
 #include "CToken.h"
+#include "EvaluationResult.h"
 
 class CCompiler;
 class CTranslationUnit;
@@ -20,6 +24,7 @@ class CPackageASTNode;
 class CClassASTNode;
 class CClassMemberASTNode;
 class CExpressionASTNode;
+class CExpressionBaseASTNode;
 
 // Debug function used to make a trace of function calls during semantation.
 //#ifdef _NDEBUG 
@@ -42,10 +47,14 @@ class CSemanter
 private:
 	CTranslationUnit*			m_context;
 	std::vector<CASTNode*>		m_scope_stack;
-	std::vector<std::string>	m_mangled;
+	std::unordered_set<std::string>			m_mangled;
+	std::unordered_map<std::string, int>	m_mangled_next_suffix;
 	
 	int m_internal_var_counter;
 
+	int m_folded_expressions;
+	int m_folded_branches;
+
 public:	
 	std::string			NewInternalVariableName				();
 	
@@ -59,6 +68,13 @@ public:
 
 	CDataType*	 		 BalanceDataTypes					(CDataType* lvalue, CDataType* rvalue);
 
+	bool				 IsConstant							(CASTNode* node);
+	CASTNode*			 FoldConstant						(CExpressionBaseASTNode* node);
+	CASTNode*			 FoldConstant						(CExpressionBaseASTNode* node, EvaluationResult result);
+	CASTNode*			 FoldBranch							(CASTNode* node, CASTNode* branch);
+	int					 GetFoldedExpressions				();
+	int					 GetFoldedBranches					();
+
 };
 
 #endif
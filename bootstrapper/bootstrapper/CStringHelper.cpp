@@ -12,6 +12,9 @@
 #include <string>
 #include <assert.h>
 #include <algorithm>
+#include <stdlib.h>
+#include <errno.h>
+#include <limits.h>
 
 #ifdef _WIN32
 #include <cstdarg>
@@ -33,6 +36,31 @@ int	CStringHelper::ToInt(const std::string& str)
 	return atoi(str.c_str());
 }
 
+// =================================================================
+//	Converts a string written as a decimal, hexidecimal or octal
+//	literal to an int. Returns false if the string is not entirely
+//	a number, or if the number does not fit in an int.
+// =================================================================
+bool CStringHelper::TryToInt(const std::string& str, int& result)
+{
+	if (str == "")
+	{
+		return false;
+	}
+
+	char* end = NULL;
+	errno = 0;
+	long long value = strtoll(str.c_str(), &end, 0);
+
+	if (*end != '\0' || errno == ERANGE || value < INT_MIN || value > INT_MAX)
+	{
+		return false;
+	}
+
+	result = (int)value;
+	return true;
+}
+
 // =================================================================
 //	Converts a string to a float.
 // =================================================================
@@ -40,6 +40,7 @@ public:
 	static std::string				ToHexString		(int code);
 	
 	static int						ToInt			(const std::string& str);
+	static bool						TryToInt		(const std::string& str, int& result);
 	static float					ToFloat			(const std::string& str);
 
 	template<typename T>
@@ -70,6 +70,12 @@ CASTNode* CTernaryExpressionASTNode::Semant(CSemanter* semanter)
 	// Resulting type is our left hand type.
 	ExpressionResultType = left_hand_expr->ExpressionResultType;
 
+	// If the condition is constant we can just use the resulting expression.
+	if (semanter->IsConstant(Expression))
+	{
+		return Expression->Evaluate(semanter->GetContext()).GetBool() ? LeftValue : RightValue;
+	}
+
 	return this;
 }
 
@@ -19,6 +19,7 @@
 #include "CIdentifierDataType.h"
 
 #include "CTranslator.h"
+#include "CProfiler.h"
 
 #include <stdexcept>
 #include <assert.h>
@@ -48,6 +49,10 @@ CTranslationUnit::CTranslationUnit(CCompiler* compiler, std::string file_path, s
 	m_filename  = CPathHelper::StripDirectory(m_file_path);
 	m_defines   = defines;
 	m_entry_point = NULL;
+	m_line_offsets_valid = false;
+	m_import_ticks = 0;
+
+	m_units_by_path.insert(std::pair<std::string, CTranslationUnit*>(m_file_path, this));
 }
 
 // =================================================================
@@ -100,6 +105,8 @@ CASTNode* CTranslationUnit::GetASTRoot()
 // =================================================================
 std::string& CTranslationUnit::GetSource() 
 { 
+	// Caller may modify the source, so our line index is no longer trustworthy.
+	m_line_offsets_valid = false;
 	return m_source;
 }
 
@@ -200,52 +207,37 @@ int CTranslationUnit::GetLastLineColumn()
 bool CTranslationUnit::AddUsingFile(std::string file, bool isNative, bool isLibrary, bool isCopy)
 {
 	std::string cleaned = CPathHelper::CleanPath(file);
+	std::string key		= CStringHelper::ToLower(cleaned);
 
 	if (isLibrary == true)
 	{
-		for (std::vector<std::string>::iterator iter = m_library_files.begin(); iter != m_library_files.end(); iter++)
+		if (!m_library_file_set.insert(key).second)
 		{
-			std::string clean_iter = *iter;
-			if (CStringHelper::ToLower(cleaned) == CStringHelper::ToLower(clean_iter))
-			{
-				return false;
-			}
+			return false;
 		}
 		m_library_files.push_back(cleaned);
 	}
 	else if (isCopy == true)
 	{
-		for (std::vector<std::string>::iterator iter = m_copy_files.begin(); iter != m_copy_files.end(); iter++)
+		if (!m_copy_file_set.insert(key).second)
 		{
-			std::string clean_iter = *iter;
-			if (CStringHelper::ToLower(cleaned) == CStringHelper::ToLower(clean_iter))
-			{
-				return false;
-			}
+			return false;
 		}
 		m_copy_files.push_back(cleaned);
 	}
 	else if (isNative == true)
  	{
-		for (std::vector<std::string>::iterator iter = m_native_files.begin(); iter != m_native_files.end(); iter++)
+		if (!m_native_file_set.insert(key).second)
 		{
-			std::string clean_iter = *iter;
-			if (CStringHelper::ToLower(cleaned) == CStringHelper::ToLower(clean_iter))
-			{
-				return false;
-			}
+			return false;
 		}
 		m_native_files.push_back(cleaned);
 	}
 	else
 	{
-		for (std::vector<std::string>::iterator iter = m_using_files.begin(); iter != m_using_files.end(); iter++)
+		if (!m_using_file_set.insert(key).second)
 		{
-			std::string clean_iter = *iter;
-			if (CStringHelper::ToLower(cleaned) == CStringHelper::ToLower(clean_iter))
-			{
-				return false;
-			}
+			return false;
 		}
 		m_using_files.push_back(cleaned);
 	}
@@ -254,31 +246,61 @@ bool CTranslationUnit::AddUsingFile(std::string file, bool isNative, bool isLibr
 }
 
 // =================================================================
-//	Emits a fatal error and aborts compilation of this translation
-//  unit.
+//	Gets the given (1-based) row of this units source code. The
+//	line-offset index is built on first use so diagnostics do not
+//	have to rescan the source for every message.
 // =================================================================
-void CTranslationUnit::FatalError(std::string msg, std::string source, int row, int column)
+std::string CTranslationUnit::GetSourceLine(int row)
 {
-	std::string line	   = "";
-	
-	if (source == m_file_path)
+	if (m_line_offsets_valid == false)
 	{
-		line = CStringHelper::Replace(CStringHelper::GetLineInString(m_source, row - 1), "\t", "    ");
-	}
-	else
-	{
-		line = "(could not retrieve source code)";
-		for (std::vector<CTranslationUnit*>::iterator iter = m_imported_units.begin(); iter != m_imported_units.end(); iter++)
+		m_line_offsets.clear();
+		m_line_offsets.push_back(0);
+
+		for (unsigned int i = 0; i < m_source.size(); i++)
 		{
-			CTranslationUnit* unit = *iter;
-			if (unit->m_file_path == source)
+			if (m_source[i] == '\n')
 			{
-				line = CStringHelper::Replace(CStringHelper::GetLineInString(unit->m_source, row - 1), "\t", "    ");;
-				break;
+				m_line_offsets.push_back(i + 1);
 			}
 		}
-	}	
-	
+
+		m_line_offsets_valid = true;
+	}
+
+	if (row < 1 || row > (int)m_line_offsets.size())
+	{
+		return "";
+	}
+
+	int start = m_line_offsets.at(row - 1);
+	int end	  = (row < (int)m_line_offsets.size() ? m_line_offsets.at(row) - 1 : m_source.size());
+
+	return m_source.substr(start, end - start);
+}
+
+// =================================================================
+//	Gets the line of source code a diagnostic refers to, looking
+//	the source file up in the units we have imported.
+// =================================================================
+std::string CTranslationUnit::GetDiagnosticLine(std::string source, int row)
+{
+	std::unordered_map<std::string, CTranslationUnit*>::iterator iter = m_units_by_path.find(source);
+	if (iter == m_units_by_path.end())
+	{
+		return "(could not retrieve source code)";
+	}
+
+	return iter->second->GetSourceLine(row);
+}
+
+// =================================================================
+//	Emits a fatal error and aborts compilation of this translation
+//  unit.
+// =================================================================
+void CTranslationUnit::FatalError(std::string msg, std::string source, int row, int column)
+{
+	std::string line	   = CStringHelper::Replace(GetDiagnosticLine(source, row), "\t", "    ");
 	std::string arrow_line = CStringHelper::PadLeft("^", column - 1);
 
 	printf("\n");
@@ -303,7 +325,7 @@ void CTranslationUnit::FatalError(std::string msg, CToken& token)
 // =================================================================
 void CTranslationUnit::Error(std::string msg, std::string source, int row, int column)
 {
-	std::string line	   = CStringHelper::GetLineInString(m_source, row - 1);
+	std::string line	   = GetDiagnosticLine(source, row);
 	std::string arrow_line = CStringHelper::PadLeft("^", column - 1);
 	
 	printf("\n");
@@ -325,7 +347,7 @@ void CTranslationUnit::Error(std::string msg, CToken& token)
 // =================================================================
 void CTranslationUnit::Warning(std::string msg, std::string source, int row, int column)
 {
-	std::string line	   = CStringHelper::GetLineInString(m_source, row - 1);
+	std::string line	   = GetDiagnosticLine(source, row);
 	std::string arrow_line = CStringHelper::PadLeft("^", column - 1);
 	
 	printf("\n");
@@ -347,12 +369,7 @@ void CTranslationUnit::Warning(std::string msg, CToken& token)
 // =================================================================
 void CTranslationUnit::Info(std::string msg, std::string source, int row, int column)
 {
-	std::string line	   = CStringHelper::GetLineInString(m_source, row - 1);
-	std::string arrow_line = CStringHelper::PadLeft("^", column - 1);
-	
 	printf("%s(%i:%i): Info: %s\n", source.c_str(), row, column, msg.c_str());
-	//printf("%s\n", line.c_str());
-	//printf("%s\n", arrow_line.c_str());
 }
 
 // =================================================================
@@ -373,6 +390,10 @@ bool CTranslationUnit::Evaluate(std::string expr)
 	{
 		m_file_path = "<eval>";
 		m_source = expr;
+		m_line_offsets_valid = false;
+
+		m_units_by_path.clear();
+		m_units_by_path.insert(std::pair<std::string, CTranslationUnit*>(m_file_path, this));
 			
 		// Tokenize.
 		if (!m_lexer.Process(this))
@@ -462,6 +483,11 @@ bool CTranslationUnit::Compile(bool importedPackage, CTranslationUnit* importing
 	try
 	{
 		int start_tick_count = GetTicks();
+		CProfiler* profiler = m_compiler->GetProfiler();
+
+		// AST nodes and data types for the whole compile are allocated from the 
+		// main package's arena, and released when it is destroyed.
+		CArenaScope arena_scope(importedPackage == true ? CArena::GetCurrent() : &m_arena);
 
 		if (importedPackage == false)
 		{
@@ -480,15 +506,24 @@ bool CTranslationUnit::Compile(bool importedPackage, CTranslationUnit* importing
 		}
 			
 		// Preprocess the source file.
-		m_preprocessor.Process(this);
+		{
+			CProfileScope scope(profiler, "preprocess", "", m_file_path);
+			m_preprocessor.Process(this);
+		}
 
 		// Convert source file into a stream of tokens.
 		//Info("Lexical Analysis ...");
-		m_lexer.Process(this);
+		{
+			CProfileScope scope(profiler, "lex", "", m_file_path);
+			m_lexer.Process(this);
+		}
 		
 		// Convert the token stream info an AST representation.
 		//Info("Parsing ...");
-		m_parser.Process(this);
+		{
+			CProfileScope scope(profiler, "parse", "", m_file_path);
+			m_parser.Process(this);
+		}
 
 		// Import support files?
 		if (importedPackage == false)
@@ -530,42 +565,35 @@ bool CTranslationUnit::Compile(bool importedPackage, CTranslationUnit* importing
 			else
 			{			
 				//Info("Importing Packages ...");	
-				std::vector<std::string> imported_files;
-				while (imported_files.size() != m_using_files.size())
-				{			
-					for (std::vector<std::string>::iterator iter = m_using_files.begin(); iter != m_using_files.end(); iter++)
-					{
-						bool imported = false;
-						for (std::vector<std::string>::iterator iter2 = imported_files.begin(); iter2 != imported_files.end(); iter2++)
-						{
-							if (*iter == *iter2)
-							{
-								imported = true;
-								break;
-							}
-						}
+				int import_tick_count = GetTicks();
 
-						if (imported == false)
-						{							
-							CTranslationUnit* unit = new CTranslationUnit(m_compiler, *iter, m_defines);
-							unit->Compile(true, this);
+				// m_using_files is our worklist, imported packages append their
+				// own using files to the end of it as they are compiled.
+				for (unsigned int next_import = 0; next_import < m_using_files.size(); next_import++)
+				{
+					std::string file = m_using_files.at(next_import);
 
-							CASTNode* unitRoot = unit->GetASTRoot();
-							CASTNode* realRoot = GetASTRoot();
-							
-							for (std::vector<CASTNode*>::iterator childIter = unitRoot->Children.begin(); childIter != unitRoot->Children.end(); childIter++)
-							{
-								realRoot->AddChild(*childIter);
-							}
+					CTranslationUnit* unit = new CTranslationUnit(m_compiler, file, m_defines);
+					m_imported_units.push_back(unit);
 
-							m_imported_units.push_back(unit);
-							imported_files.push_back(*iter);
+					// The imported package has already reported why it failed.
+					if (unit->Compile(true, this) == false)
+					{
+						throw std::runtime_error("Fatal Error");
+					}
 
-							break;
-						}
+					CASTNode* unitRoot = unit->GetASTRoot();
+					CASTNode* realRoot = GetASTRoot();
+
+					for (std::vector<CASTNode*>::iterator childIter = unitRoot->Children.begin(); childIter != unitRoot->Children.end(); childIter++)
+					{
+						realRoot->AddChild(*childIter);
 					}
-					
+
+					m_units_by_path.insert(std::pair<std::string, CTranslationUnit*>(unit->m_file_path, unit));
 				}
+
+				m_import_ticks = GetTicks() - import_tick_count;
 			}
 		}
 		
@@ -581,6 +609,11 @@ bool CTranslationUnit::Compile(bool importedPackage, CTranslationUnit* importing
 		// Check semantics are correct for AST.
 		//Info("Semantic Analysis ...");
 		m_semanter.Process(this);
+
+		if (m_semanter.GetFoldedExpressions() > 0 || m_semanter.GetFoldedBranches() > 0)
+		{
+			Info(CStringHelper::FormatString("Folded %i constant expressions and %i constant branches.", m_semanter.GetFoldedExpressions(), m_semanter.GetFoldedBranches()));
+		}
 		
 		// Check we have an entry point.
 		if (GetEntryPoint() == NULL)
@@ -588,9 +621,28 @@ bool CTranslationUnit::Compile(bool importedPackage, CTranslationUnit* importing
 			FatalError("No entry point was found in program. Entry point with the following signature is expected: int Main(string[])");
 		}
 
+		// Work out what can be reached from the entry point so we don't
+		// translate anything we don't need.
+		if (m_compiler->GetPruneUnreachable() == true)
+		{
+			m_pruner.Process(this);
+		}
+
+		// Work out which calls don't need to be virtual.
+		m_class_hierarchy.Process(this);
+
+		// Work out which objects can be kept off the heap.
+		if (m_compiler->GetEscapeAnalysis() == true)
+		{
+			m_escape_analysis.Process(this);
+		}
+
 		// Translate into target language.
 		int tick_count = GetTicks();
-		m_compiler->GetTranslator()->Process(this);		
+		{
+			CProfileScope scope(profiler, "translate", "", m_file_path);
+			m_compiler->GetTranslator()->Process(this);		
+		}
 		m_translated_files = m_compiler->GetTranslator()->GetTranslatedFiles();
 		Info(CStringHelper::FormatString("Translated %s using '%s' translator in %s ms.",
 										m_filename.c_str(), 
@@ -599,7 +651,10 @@ bool CTranslationUnit::Compile(bool importedPackage, CTranslationUnit* importing
 
 		// Invoke native compiler.
 		tick_count = GetTicks();
-		m_compiler->GetBuilder()->Process(this);
+		{
+			CProfileScope scope(profiler, "builder", "", m_file_path);
+			m_compiler->GetBuilder()->Process(this);
+		}
 		Info(CStringHelper::FormatString("Compiled %s using '%s' builder in %s ms.",
 								m_filename.c_str(), 
 								m_compiler->GetProjectConfig().GetString("BUILDER_NAME").c_str(), 
@@ -607,6 +662,8 @@ bool CTranslationUnit::Compile(bool importedPackage, CTranslationUnit* importing
 
 		// Work out elapsed time.
 		int elapsed = GetTicks() - start_tick_count;
+		Info(CStringHelper::FormatString("Imported %i packages in %i ms.", (int)m_imported_units.size(), m_import_ticks));
+		Info(CStringHelper::FormatString("Allocated %i nodes (%i KB) from arena.", m_arena.GetAllocationCount(), (int)(m_arena.GetAllocatedBytes() / 1024)));
 		Info("Generated " + m_filename + " in " + CStringHelper::ToString(elapsed) + "ms");
 
 		return true;
@@ -645,14 +702,24 @@ bool CTranslationUnit::PreProcess()
 }
 
 // =================================================================
-// 	Gets the current tick count.
+// 	Gets the current wall clock tick count in milliseconds.
 // =================================================================
 int	CTranslationUnit::GetTicks()
 {
 #ifdef _WIN32
 	return GetTickCount();	
 #elif defined(__linux__) || defined(__APPLE__)
-	return clock() / (CLOCKS_PER_SEC / 1000);
+	static time_t base_seconds = 0;
+
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+
+	if (base_seconds == 0)
+	{
+		base_seconds = tv.tv_sec;
+	}
+
+	return (int)(((tv.tv_sec - base_seconds) * 1000) + (tv.tv_usec / 1000));
 #else
 	assert(0);
 #endif
@@ -11,12 +11,18 @@
 
 #include <vector>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 
 #include "CCompiler.h"
 #include "CLexer.h"
 #include "CParser.h"
 #include "CSemanter.h"
+#include "CPruner.h"
+#include "CClassHierarchy.h"
+#include "CEscapeAnalysis.h"
 #include "CPreprocessor.h"
+#include "CArena.h"
 
 class CCompiler;
 
@@ -27,6 +33,8 @@ class CCompiler;
 class CTranslationUnit
 {
 private:
+	CArena						m_arena;
+
 	CCompiler*					m_compiler;
 	std::string					m_file_path;
 	std::string					m_filename;
@@ -36,6 +44,9 @@ private:
 	CLexer						m_lexer;
 	CParser						m_parser;
 	CSemanter					m_semanter;
+	CPruner						m_pruner;
+	CClassHierarchy				m_class_hierarchy;
+	CEscapeAnalysis				m_escape_analysis;
 	CPreprocessor				m_preprocessor;
 
 	std::vector<CToken>			m_token_list;
@@ -45,10 +56,21 @@ private:
 	std::vector<std::string>	m_library_files;
 	std::vector<std::string>	m_translated_files;
 
+	std::unordered_set<std::string>	m_using_file_set;
+	std::unordered_set<std::string>	m_native_file_set;
+	std::unordered_set<std::string>	m_copy_file_set;
+	std::unordered_set<std::string>	m_library_file_set;
+
 	int							m_last_line_row;
 	int							m_last_line_column;
 
 	std::vector<CTranslationUnit*>	m_imported_units;
+	std::unordered_map<std::string, CTranslationUnit*> m_units_by_path;
+
+	std::vector<int>				m_line_offsets;
+	bool							m_line_offsets_valid;
+
+	int								m_import_ticks;
 
 	std::vector<CDefine>			m_defines;
 
@@ -88,6 +110,9 @@ public:
 
 	bool						AddUsingFile		(std::string file, bool isNative, bool isLibrary, bool isCopy);
 
+	std::string					GetSourceLine		(int row);
+	std::string					GetDiagnosticLine	(std::string source, int row);
+
 	void FatalError	(std::string msg, std::string source="internal", int row=1, int column=1);
 	void FatalError	(std::string msg, CToken& token);
 	void Error		(std::string msg, std::string source="internal", int row=1, int column=1);
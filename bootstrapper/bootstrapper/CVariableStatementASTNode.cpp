@@ -26,7 +26,8 @@ CVariableStatementASTNode::CVariableStatementASTNode(CASTNode* parent, CToken to
 	CDeclarationASTNode(parent, token),
 	AssignmentExpression(NULL),
 	Type(NULL),
-	IsParameter(false)
+	IsParameter(false),
+	StackClass(NULL)
 {
 }
 
@@ -19,6 +19,7 @@
 
 class CDataType;
 class CExpressionBaseASTNode;
+class CClassASTNode;
 
 // =================================================================
 //	Stores information on an block statement.
@@ -32,6 +33,10 @@ public:
 	CDataType*				Type;
 	CExpressionBaseASTNode*	AssignmentExpression;
 
+	// Escape analysis infered data. Set when the variable always holds
+	// an object of this class that is stored alongside it.
+	CClassASTNode*			StackClass;
+
 	CVariableStatementASTNode(CASTNode* parent, CToken token);
 	
 	virtual std::string ToString();
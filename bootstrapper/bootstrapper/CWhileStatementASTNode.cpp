@@ -69,6 +69,13 @@ CASTNode* CWhileStatementASTNode::Semant(CSemanter* semanter)
 		BodyStatement = ReplaceChild(BodyStatement, BodyStatement->Semant(semanter));
 	}
 
+	// Remove loops that can never be entered.
+	if (semanter->IsConstant(ExpressionStatement) &&
+		ExpressionStatement->Evaluate(semanter->GetContext()).GetBool() == false)
+	{
+		return semanter->FoldBranch(this, NULL);
+	}
+
 	return this;
 }
 
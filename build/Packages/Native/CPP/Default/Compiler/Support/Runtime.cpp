@@ -7,17 +7,107 @@
 //  and ordering of this file.
 // -----------------------------------------------------------------------------
 
+#include <stdlib.h>
+#include <stdio.h>
+
+// Threads started through System.Threading are created by the collector, so
+// it has to be told to expect more than one thread. The bundled Win32 
+// collector library is built without thread support, System.Threading
+// cannot be translated for it.
+#ifndef _WIN32
+#define GC_THREADS
+#endif
 #include "Packages/Native/CPP/Default/System/GC/include/gc.h"
 
 #include "Packages/Native/CPP/Default/Compiler/Support/Runtime.hpp"
 
+// -----------------------------------------------------------------------------
+//	Reads an integer setting from the environment, returning the given value
+//	if it has not been set.
+// -----------------------------------------------------------------------------
+static int lsRuntimeGetEnvironmentInt(const char* name, int value)
+{
+	const char* text = getenv(name);
+	if (text != NULL && text[0] != '\0')
+	{
+		return atoi(text);
+	}
+	return value;
+}
+
 // -----------------------------------------------------------------------------
 //	Called at the start of the entry point, initializes the runtime.
+//	Every garbage collector setting can be overridden when the program is
+//	started with the LS_GC_MARKERS, LS_GC_INITIAL_HEAP, 
+//	LS_GC_FREE_SPACE_DIVISOR and LS_GC_INCREMENTAL environment variables.
+//	Starting it with LS_GC_STATS=1 records collection pauses and prints them
+//	when the program exits.
 // -----------------------------------------------------------------------------
-void lsRuntimeInit()
+void lsRuntimeInit(int gc_markers, int gc_initial_heap, int gc_free_space_divisor, bool gc_incremental)
 {
+	gc_markers				= lsRuntimeGetEnvironmentInt("LS_GC_MARKERS",				gc_markers);
+	gc_initial_heap			= lsRuntimeGetEnvironmentInt("LS_GC_INITIAL_HEAP",			gc_initial_heap);
+	gc_free_space_divisor	= lsRuntimeGetEnvironmentInt("LS_GC_FREE_SPACE_DIVISOR",	gc_free_space_divisor);
+	gc_incremental			= lsRuntimeGetEnvironmentInt("LS_GC_INCREMENTAL",			gc_incremental ? 1 : 0) != 0;
+
+	// The collector reads the number of marker threads from its own 
+	// environment variable when it starts.
+	if (gc_markers > 0)
+	{
+		char markers[16];
+		sprintf(markers, "%d", gc_markers);
+#ifdef _WIN32
+		_putenv_s("GC_MARKERS", markers);
+#else
+		setenv("GC_MARKERS", markers, 1);
+#endif
+	}
+
 	GC_INIT();
-	GC_enable_incremental();
+#ifdef GC_THREADS
+	GC_allow_register_threads();
+#endif
+
+	// Only the bundled Linux collector library is built with parallel
+	// marking, elsewhere the marker count is ignored, so say so rather
+	// than leave it looking as if it took effect.
+	if (gc_markers > 1)
+	{
+#ifdef GC_THREADS
+		bool parallel = (GC_get_parallel() != 0);
+#else
+		bool parallel = false;
+#endif
+		if (parallel == false)
+		{
+			fprintf(stderr, "GC: %d markers were requested, but the garbage collector was built without parallel marking, marking on 1 thread.\n", gc_markers);
+		}
+	}
+
+	// The initial heap size is given in megabytes.
+	if (gc_initial_heap > 0)
+	{
+		size_t heap_size	= GC_get_heap_size();
+		size_t wanted_size	= (size_t)gc_initial_heap * 1024 * 1024;
+		if (wanted_size > heap_size)
+		{
+			GC_expand_hp(wanted_size - heap_size);
+		}
+	}
+	if (gc_free_space_divisor > 0)
+	{
+		GC_set_free_space_divisor(gc_free_space_divisor);
+	}
+	if (gc_incremental == true)
+	{
+		GC_enable_incremental();
+	}
+
+	lsGCObject::GCInit(gc_incremental);
+	if (lsRuntimeGetEnvironmentInt("LS_GC_STATS", 0) != 0)
+	{
+		lsGCPauses.Enabled = true;
+	}
 }
 
 // -----------------------------------------------------------------------------
@@ -25,4 +115,8 @@ void lsRuntimeInit()
 // -----------------------------------------------------------------------------
 void lsRuntimeDeInit()
 {
+	if (lsGCPauses.Enabled == true)
+	{
+		lsGCObject::GCPrintStats();
+	}
 }
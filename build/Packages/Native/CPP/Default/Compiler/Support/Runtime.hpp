@@ -15,8 +15,10 @@
 // -----------------------------------------------------------------------------
 //	These functions are called at the start and end of the entry point 
 //	respectively and are responsible for starting and shutting down the runtime.
+//	The garbage collector settings are taken from the project, a value of 0
+//	leaves the collectors own default in place.
 // -----------------------------------------------------------------------------
-void lsRuntimeInit();
+void lsRuntimeInit(int gc_markers = 0, int gc_initial_heap = 0, int gc_free_space_divisor = 0, bool gc_incremental = true);
 void lsRuntimeDeInit();
 
 #endif // __LS_PACKAGES_NATIVE_WIN32_COMPILER_SUPPORT_RUNTIME__
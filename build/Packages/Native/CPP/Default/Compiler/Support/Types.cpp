@@ -17,16 +17,32 @@
 #include <sstream>
 #include <map>
 
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <time.h>
+#endif
+
 #include "Packages/Native/CPP/Default/System/GC/include/gc.h"
+#include "Packages/Native/CPP/Default/System/GC/include/gc_mark.h"
+#include "Packages/Native/CPP/Default/System/GC/include/gc_typed.h"
 
 #include "Packages/Native/CPP/Default/Compiler/Support/Types.hpp"
 
+// =========================================================================
+//	Threading.
+// =========================================================================
+bool lsMultiThreaded = false;
+
 // =========================================================================
 //	lsStringBuffer.
 // =========================================================================
 lsStringBuffer::lsStringBuffer() :
 	Buffer(NULL),
 	Length(0),
+	Hash(0),
+	Free(NULL),
+	Owner(NULL),
 	m_ref_count(1)
 {
 }
@@ -36,18 +52,37 @@ lsStringBuffer::lsStringBuffer() :
 // -------------------------------------------------------------------------
 void lsStringBuffer::Release()
 {
-	--m_ref_count;
+	int ref_count = 0;
+	if (lsMultiThreaded == true)
+	{
+		ref_count = lsAtomicAdd(&m_ref_count, -1) - 1;
+	}
+	else
+	{
+		ref_count = --m_ref_count;
+	}
 		
 #ifdef _DEBUG
-	if (m_ref_count < 0)
+	if (ref_count < 0)
 	{
 		throw lsInternalGCException();		
 	}
 #endif
 
-	if (m_ref_count == 0)
+	if (ref_count == 0)
 	{
-		delete[] Buffer;
+		if (Owner != NULL)
+		{
+			Owner->Release();
+		}
+		else if (Free != NULL)
+		{
+			Free(this);
+		}
+		else
+		{
+			delete[] Buffer;
+		}
 		delete this;
 	}
 }
@@ -57,7 +92,14 @@ void lsStringBuffer::Release()
 // -------------------------------------------------------------------------
 void lsStringBuffer::Retain()
 {
-	m_ref_count++;
+	if (lsMultiThreaded == true)
+	{
+		lsAtomicAdd(&m_ref_count, 1);
+	}
+	else
+	{
+		m_ref_count++;
+	}
 }
 
 // -------------------------------------------------------------------------
@@ -66,21 +108,6 @@ void lsStringBuffer::Retain()
 // -------------------------------------------------------------------------
 lsStringBuffer* lsStringBuffer::Allocate(int size)
 {
-	static lsStringBuffer* g_empty_string = NULL;		
-	if (size == 0)
-	{
-		if (g_empty_string == NULL)
-		{
-			g_empty_string 				= new lsStringBuffer();
-			g_empty_string->Buffer		= new char[1];
-			g_empty_string->Length		= 0;
-			g_empty_string->m_ref_count	= 1;
-			g_empty_string->Buffer[0] 	= '\0';
-		}
-		g_empty_string->Retain();
-		return g_empty_string;
-	}		
-
 	lsStringBuffer* buffer = new lsStringBuffer();
 	buffer->Buffer		= new char[size + 1];
 	buffer->Length		= size;
@@ -96,50 +123,66 @@ lsStringBuffer* lsStringBuffer::Allocate(int size)
 
 lsString::~lsString()
 {
-	m_buffer->Release();
+	if (IsInline() == false)
+	{
+		m_buffer->Release();
+	}
 }
 
-lsString::lsString()
+lsString::lsString() :
+	m_length(0)
 {
-	m_buffer = lsStringBuffer::Allocate(0);
+	m_inline[0] = '\0';
 }
 
-lsString::lsString(const lsString& string)
+lsString::lsString(const lsString& string) :
+	m_length(string.m_length)
 {
-	m_buffer = string.m_buffer;
-	m_buffer->Retain();
+	memcpy(m_inline, string.m_inline, sizeof(m_inline));
+	if (IsInline() == false)
+	{
+		m_buffer->Retain();
+	}
 }
 
-lsString::lsString(lsStringBuffer* buffer)
+lsString::lsString(lsStringBuffer* buffer) :
+	m_length(buffer->Length)
 {
-	m_buffer = buffer;
+	if (IsInline() == true)
+	{
+		memcpy(m_inline, buffer->Buffer, m_length + 1);
+		buffer->Release();
+	}
+	else
+	{
+		m_buffer = buffer;
+	}
 }
 
 lsString::lsString(const char* buffer)
 {
 	int length = strlen(buffer);
-	m_buffer = lsStringBuffer::Allocate(length);
-	memcpy(m_buffer->Buffer, buffer, length); 
+	memcpy(Reserve(length), buffer, length); 
 }
 
 lsString::lsString(const char* buffer, int length)
 {
-	m_buffer = lsStringBuffer::Allocate(length);
-	memcpy(m_buffer->Buffer, buffer, length); 
+	memcpy(Reserve(length), buffer, length); 
 }
 
-lsString::lsString(char chr)
+lsString::lsString(char chr) :
+	m_length(1)
 {
-	m_buffer = lsStringBuffer::Allocate(1);
-	m_buffer->Buffer[0] = chr;
+	m_inline[0] = chr;
+	m_inline[1] = '\0';
 }
 
 lsString::lsString(lsArray<int>* chrs)
 {
-	m_buffer = lsStringBuffer::Allocate(chrs->Length());
+	char* buffer = Reserve(chrs->Length());
 	for (int i = 0; i < chrs->Length(); i++)
 	{
-		m_buffer->Buffer[i] = (char)((*chrs)[i]);
+		buffer[i] = (char)((*chrs)[i]);
 	}
 }
 
@@ -149,8 +192,7 @@ lsString::lsString(int value)
 	sprintf(buffer, "%i", value);
 	
 	int length = strlen(buffer);
-	m_buffer = lsStringBuffer::Allocate(length);
-	memcpy(m_buffer->Buffer, buffer, length);
+	memcpy(Reserve(length), buffer, length);
 }
 
 lsString::lsString(float value)
@@ -159,72 +201,119 @@ lsString::lsString(float value)
 	sprintf(buffer, "%f", value);
 	
 	int length = strlen(buffer);
-	m_buffer = lsStringBuffer::Allocate(length);
-	memcpy(m_buffer->Buffer, buffer, length);	
+	memcpy(Reserve(length), buffer, length);	
+}
+
+// -------------------------------------------------------------------------
+//	Sets the length of a string that is being constructed, and returns
+//	the buffer its characters should be written to. Short strings are
+//	stored inline, longer ones get a buffer of their own.
+// -------------------------------------------------------------------------
+char* lsString::Reserve(int length)
+{
+	m_length = length;
+	if (IsInline() == true)
+	{
+		m_inline[length] = '\0';
+		return m_inline;
+	}
+	else
+	{
+		m_buffer = lsStringBuffer::Allocate(length);
+		return m_buffer->Buffer;
+	}
+}
+
+// -------------------------------------------------------------------------
+//	Calculates a hash of the given characters (32 bit FNV-1a). Never 
+//	returns zero so buffers can use zero to mean not yet calculated.
+// -------------------------------------------------------------------------
+int lsString::CalculateHash(const char* buffer, int length)
+{
+	unsigned int hash = 2166136261u;
+	for (int i = 0; i < length; i++)
+	{
+		hash ^= (unsigned char)buffer[i];
+		hash *= 16777619u;
+	}
+	return hash == 0 ? 1 : (int)hash;
 }
 
-int lsString::Length() const
+// -------------------------------------------------------------------------
+//	Gets a hash of the strings characters. Equal strings always have the
+//	same hash. Longer strings cache it in their buffer so it is only ever
+//	calculated once, inline strings are short enough to just recalculate.
+// -------------------------------------------------------------------------
+int lsString::GetHashCode() const
 {
-	return m_buffer->Length;
+	if (IsInline() == true)
+	{
+		return CalculateHash(m_inline, m_length);
+	}
+	if (m_buffer->Hash == 0)
+	{
+		m_buffer->Hash = CalculateHash(m_buffer->Buffer, m_length);
+	}
+	return m_buffer->Hash;
 }
 
 lsString lsString::GetIndex(int index) const
 {
 #ifdef _DEBUG
-	if (index < 0 || index >= m_buffer->Length)
+	if (index < 0 || index >= m_length)
 	{
 		throw lsOutOfBoundsException();		
 	}
 #endif
-	return lsString(m_buffer->Buffer[index]);
+	return lsString(GetBuffer()[index]);
 }
 
 lsString lsString::GetSlice(int start_pos) const
 {
-	return GetSlice(start_pos, m_buffer->Length);
+	return GetSlice(start_pos, m_length);
 }
 
 lsString lsString::GetSlice(int start_pos, int end_pos) const
 {
 	if (start_pos < 0)
 	{
-		start_pos += m_buffer->Length;
+		start_pos += m_length;
 		if (start_pos < 0)
 		{
 			start_pos = 0;
 		}		
 	}
-	else if (start_pos > m_buffer->Length)
+	else if (start_pos > m_length)
 	{
-		start_pos = m_buffer->Length;
+		start_pos = m_length;
 	}
 	
 	if (end_pos < 0)
 	{
-		end_pos += m_buffer->Length;
+		end_pos += m_length;
 	}
-	else if (end_pos > m_buffer->Length)
+	else if (end_pos > m_length)
 	{
-		end_pos = m_buffer->Length;
+		end_pos = m_length;
 	}
 
 	if (start_pos >= end_pos)
 	{
 		return lsString();
 	}
-	else if (start_pos == 0 && end_pos == m_buffer->Length)
+	else if (start_pos == 0 && end_pos == m_length)
 	{
 		return lsString(*this);
 	}
 	else
 	{
-		return lsString(m_buffer->Buffer + start_pos, end_pos - start_pos);
+		return lsString(GetBuffer() + start_pos, end_pos - start_pos);
 	}
 }
 
 const char* lsString::ToCString() const
 {
-	return m_buffer->Buffer;
+	return GetBuffer();
 }
 
 float lsString::ToFloat() const
@@ -244,7 +333,7 @@ int lsString::HexToInt() const
 
 int lsString::ToChar() const
 {
-	return Length() <= 0 ? 0 : m_buffer->Buffer[0];
+	return m_length <= 0 ? 0 : GetBuffer()[0];
 }
 
 lsString lsString::FromChar(int chr)
@@ -266,52 +355,67 @@ lsString lsString::FromChars(lsArray<int>* chr)
 
 int lsString::Compare(const lsString& other) const 
 {
-	int min_size = (other.m_buffer->Length < m_buffer->Length ? 
-						other.m_buffer->Length : 
-						m_buffer->Length);
+	const char* buffer		 = GetBuffer();
+	const char* other_buffer = other.GetBuffer();
 
-	for (int i = 0; i < min_size; i++)
+	int min_size = (other.m_length < m_length ? 
+						other.m_length : 
+						m_length);
+
+	int diff = memcmp(other_buffer, buffer, min_size);
+	if (diff != 0)
 	{
-		int diff = (other.m_buffer->Buffer[i] - m_buffer->Buffer[i]);
-		if (diff != 0)
-		{
-			return diff;
-		}
+		return diff;
 	}
 
-	return (other.m_buffer->Length - m_buffer->Length);
+	return (other.m_length - m_length);
 }
 
 lsString& lsString::operator =(const lsString& other)
 {
-	other.m_buffer->Retain();
-	m_buffer->Release();
-	m_buffer = other.m_buffer;
+	if (this == &other)
+	{
+		return *this;
+	}
+
+	if (other.IsInline() == false)
+	{
+		other.m_buffer->Retain();
+	}
+	if (IsInline() == false)
+	{
+		m_buffer->Release();
+	}
+
+	memcpy(m_inline, other.m_inline, sizeof(m_inline));
+	m_length = other.m_length;
+
 	return *this;
 }
 
 lsString lsString::operator +(const lsString& other) const
 {
-	if (m_buffer->Length == 0)
+	if (m_length == 0)
 	{
 		return other;
 	}
-	if (other.m_buffer->Length == 0)
+	if (other.m_length == 0)
 	{
 		return *this;
 	}
 
-	lsStringBuffer* newBuffer = lsStringBuffer::Allocate(m_buffer->Length + other.m_buffer->Length);
+	lsString result;
+	char* buffer = result.Reserve(m_length + other.m_length);
 
-	memcpy(newBuffer->Buffer, 
-			m_buffer->Buffer, 
-			m_buffer->Length);
+	memcpy(buffer, 
+			GetBuffer(), 
+			m_length);
 
-	memcpy(newBuffer->Buffer + m_buffer->Length, 
-			other.m_buffer->Buffer, 
-			other.m_buffer->Length);
+	memcpy(buffer + m_length, 
+			other.GetBuffer(), 
+			other.m_length);
 
-	return lsString(newBuffer);
+	return result;
 }
 
 lsString& lsString::operator +=(const lsString& other) 
@@ -319,18 +423,29 @@ lsString& lsString::operator +=(const lsString& other)
 	return operator =(*this + other);
 }
 
-char lsString::operator [](int index) const
-{
-	return GetIndex(index).ToChar();
-}
-
 bool lsString::operator ==(const lsString& other) const
 {
-	if (m_buffer->Length != other.m_buffer->Length)
+	if (m_length != other.m_length)
+	{
+		return false;
+	}
+	if (IsInline() == true)
+	{
+		return (memcmp(m_inline, other.m_inline, m_length) == 0);
+	}
+
+	// Strings sharing a buffer are always equal, and strings whose hashes
+	// have already been calculated can only be equal if they match.
+	if (m_buffer == other.m_buffer)
+	{
+		return true;
+	}
+	if (m_buffer->Hash != 0 && other.m_buffer->Hash != 0 && m_buffer->Hash != other.m_buffer->Hash)
 	{
 		return false;
 	}
-	return (memcmp(m_buffer->Buffer, other.m_buffer->Buffer, m_buffer->Length) == 0);
+
+	return (memcmp(m_buffer->Buffer, other.m_buffer->Buffer, m_length) == 0);
 }
 
 bool lsString::operator !=(const lsString& other) const
@@ -358,6 +473,48 @@ bool lsString::operator >=(const lsString& other) const
 	return Compare(other) >= 0;
 }
 
+// =========================================================================
+//	lsGCLayout.
+// =========================================================================
+
+// Set when objects are allocated with their layouts, see GCInit.
+static bool g_gc_use_layouts = false;
+
+// Number of classes whose instances are scanned using their layouts.
+static volatile int g_gc_precise_classes = 0;
+
+lsGCLayout::lsGCLayout(int size, void (*describe)(lsGCLayout* layout)) :
+	m_words(size / sizeof(GC_word)),
+	m_has_references(false),
+	m_descriptor(0)
+{
+	int bitmap_words = (m_words + GC_WORDSZ - 1) / GC_WORDSZ;
+	
+	m_bitmap = new size_t[bitmap_words];
+	memset(m_bitmap, 0, bitmap_words * sizeof(size_t));
+
+	describe(this);
+
+	if (g_gc_use_layouts == true)
+	{
+		// The collector copies the bitmap if it does not fit in the descriptor.
+		if (m_has_references == true)
+		{
+			m_descriptor = GC_make_descriptor((GC_bitmap)m_bitmap, m_words);
+		}
+		lsAtomicAdd(&g_gc_precise_classes, 1);
+	}
+
+	delete[] m_bitmap;
+	m_bitmap = NULL;
+}
+
+void lsGCLayout::AddReference(size_t offset)
+{
+	GC_set_bit((GC_bitmap)m_bitmap, offset / sizeof(GC_word));
+	m_has_references = true;
+}
+
 // =========================================================================
 //	lsGCObject.
 // =========================================================================
@@ -374,29 +531,190 @@ void lsGCObject::operator delete(void *p)
 {
 }
 	
-lsGCObject* lsGCObject::GCAllocate(int size)
+// Large buffers are always referenced from their start by the array that
+// owns them, so the collector can ignore pointers past their first page.
+#define LS_GC_LARGE_BUFFER_SIZE (64 * 1024)
+
+lsGCPauseStats lsGCPauses;
+
+
+// -------------------------------------------------------------------------
+//	Gets the time in milliseconds, used to time collection pauses.
+// -------------------------------------------------------------------------
+static double lsGCGetTime()
+{
+#ifdef _WIN32
+	LARGE_INTEGER frequency;
+	LARGE_INTEGER counter;
+	QueryPerformanceFrequency(&frequency);
+	QueryPerformanceCounter(&counter);
+	return (double)counter.QuadPart * 1000.0 / (double)frequency.QuadPart;
+#else
+	timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return (double)time.tv_sec * 1000.0 + (double)time.tv_nsec / 1000000.0;
+#endif
+}
+
+// -------------------------------------------------------------------------
+//	Adds the time a collection took to the pause statistics.
+// -------------------------------------------------------------------------
+static void lsGCRecordPause(double time)
+{
+	int bucket = 0;
+	for (double limit = 1.0; bucket < LS_GC_PAUSE_BUCKETS - 1 && time >= limit; limit *= 2.0)
+	{
+		bucket++;
+	}
+
+	while (lsAtomicCompareExchange(&lsGCPauses.Lock, 0, 1) != 0)
+	{
+	}
+
+	lsGCPauses.Count++;
+	lsGCPauses.TotalTime += time;
+	if (time > lsGCPauses.MaxTime)
+	{
+		lsGCPauses.MaxTime = time;
+	}
+	lsGCPauses.Histogram[bucket]++;
+
+	lsAtomicExchange(&lsGCPauses.Lock, 0);
+}
+
+// -------------------------------------------------------------------------
+//	Allocates memory from the collector. Buffers are allocated as arrays 
+//	of atomic or pointer elements, other memory holds a single object that
+//	is scanned using its layout if it has one, or conservatively if not.
+// -------------------------------------------------------------------------
+static void* lsGCMalloc(int size, bool atomic, bool buffer, const lsGCLayout* layout)
+{
+	if (layout != NULL)
+	{
+		return GC_MALLOC_EXPLICITLY_TYPED(size, layout->GetDescriptor());
+	}
+	else if (buffer == false)
+	{
+		return GC_MALLOC(size);
+	}
+	else if (size >= LS_GC_LARGE_BUFFER_SIZE)
+	{
+		return (atomic == true ? GC_MALLOC_ATOMIC_IGNORE_OFF_PAGE(size) : GC_MALLOC_IGNORE_OFF_PAGE(size));
+	}
+	else
+	{
+		return (atomic == true ? GC_MALLOC_ATOMIC(size) : GC_MALLOC(size));
+	}
+}
+
+// -------------------------------------------------------------------------
+//	Called by the collector when it starts a full collection, with the 
+//	world stopped. Memory can not be allocated here.
+// -------------------------------------------------------------------------
+static void GC_CALLBACK lsGCCollectionStarted()
+{
+	if (lsGCPauses.Enabled == true && lsGCPauses.TimeAllocations == false)
+	{
+		lsGCPauses.CollectionStart = lsGCGetTime();
+		lsAtomicExchange(&lsGCPauses.Collecting, 1);
+	}
+}
+
+// -------------------------------------------------------------------------
+//	Records the pause of the collection that was started last. Only the
+//	first thread to get here once the world restarts records it.
+// -------------------------------------------------------------------------
+static void lsGCFinishPause()
+{
+	if (lsAtomicCompareExchange(&lsGCPauses.Collecting, 1, 0) == 1)
+	{
+		lsGCRecordPause(lsGCGetTime() - lsGCPauses.CollectionStart);
+	}
+}
+
+// -------------------------------------------------------------------------
+//	Allocates memory from the collector, running a full collection and 
+//	trying again if there is none left. 
+// -------------------------------------------------------------------------
+static void* lsGCMallocOrCollect(int size, bool atomic, bool buffer, const lsGCLayout* layout)
 {
-	GCCollect(false);
+	void* ptr = NULL;
+
+	if (lsGCPauses.Enabled == true && lsGCPauses.TimeAllocations == true)
+	{
+		GC_word collections = GC_get_gc_no();
+		double	start		= lsGCGetTime();
+
+		ptr = lsGCMalloc(size, atomic, buffer, layout);
+
+		if (GC_get_gc_no() != collections)
+		{
+			lsGCRecordPause(lsGCGetTime() - start);
+		}
+	}
+	else
+	{
+		ptr = lsGCMalloc(size, atomic, buffer, layout);
+
+		if (lsGCPauses.Collecting != 0)
+		{
+			lsGCFinishPause();
+		}
+	}
 
-	void* ptr = GC_MALLOC(size);
 	if (ptr == NULL)
 	{
-		GCCollect(true);
-		ptr = GC_MALLOC(size);
+		lsGCObject::GCCollect(true);
+		ptr = lsGCMalloc(size, atomic, buffer, layout);
 		if (ptr == NULL)
 		{
 			throw new lsOutOfMemoryException();
 			return NULL;
 		}
 	}
-	
-	lsGCObject* obj = static_cast<lsGCObject*>(ptr);
 
-	return obj;
+	return ptr;
+}
+
+lsGCObject* lsGCObject::GCAllocate(int size)
+{
+	return static_cast<lsGCObject*>(lsGCMallocOrCollect(size, false, false, NULL));
+}	
+
+lsGCObject* lsGCObject::GCAllocateTyped(int size, const lsGCLayout* layout)
+{
+	if (g_gc_use_layouts == false)
+	{
+		return GCAllocate(size);
+	}
+
+	// Objects without references never need scanning at all.
+	if (layout->HasReferences() == false)
+	{
+		return static_cast<lsGCObject*>(GCAllocateBuffer(size, true));
+	}
+
+	return static_cast<lsGCObject*>(lsGCMallocOrCollect(size, false, false, layout));
 }	
+
+void* lsGCObject::GCAllocateBuffer(int size, bool atomic)
+{
+	void* ptr = lsGCMallocOrCollect(size, atomic, true, NULL);
+
+	// The collector only clears memory it is going to scan.
+	if (atomic == true)
+	{
+		memset(ptr, 0, size);
+	}
+
+	return ptr;
+}
 	
 void lsGCObject::GCCollect(bool full)
 {
+	GC_word collections = GC_get_gc_no();
+	double	start		= lsGCGetTime();
+
 	if (full == true)
 	{
 		GC_gcollect();
@@ -405,6 +723,118 @@ void lsGCObject::GCCollect(bool full)
 	{
 		GC_collect_a_little();
 	}
+
+	if (lsGCPauses.Enabled == true && lsGCPauses.TimeAllocations == true)
+	{
+		if (GC_get_gc_no() != collections)
+		{
+			lsGCRecordPause(lsGCGetTime() - start);
+		}
+	}
+	else if (lsGCPauses.Collecting != 0)
+	{
+		lsGCFinishPause();
+	}
+}
+
+// -------------------------------------------------------------------------
+//	Called once the collector has been initialized to start watching for 
+//	collections. Statistics are recorded once lsGCPauses.Enabled is set.
+//
+//	Objects are only allocated with their layouts when the collector is not
+//	incremental. The incremental collector runs more often once less of the
+//	heap needs scanning, and its pauses get longer rather than shorter.
+// -------------------------------------------------------------------------
+void lsGCObject::GCInit(bool incremental)
+{
+	lsGCPauses.TimeAllocations = incremental;
+	GC_set_start_callback(lsGCCollectionStarted);
+
+	g_gc_use_layouts = (incremental == false);
+}
+
+// -------------------------------------------------------------------------
+//	Writes a summary of the collectors work so far to stderr.
+// -------------------------------------------------------------------------
+void lsGCObject::GCPrintStats()
+{
+	GC_word heap_size		= 0;
+	GC_word free_bytes		= 0;
+	GC_word unmapped_bytes	= 0;
+	GC_word bytes_since_gc	= 0;
+	GC_word total_bytes		= 0;
+	GC_get_heap_usage_safe(&heap_size, &free_bytes, &unmapped_bytes, &bytes_since_gc, &total_bytes);
+
+	fprintf(stderr, "GC: %lu collections, %.1f MB heap, %.1f MB free, %.1f MB allocated since last collection, %.1f MB allocated in total\n",
+		(unsigned long)GC_get_gc_no(),
+		heap_size		/ (1024.0 * 1024.0),
+		free_bytes		/ (1024.0 * 1024.0),
+		bytes_since_gc	/ (1024.0 * 1024.0),
+		total_bytes		/ (1024.0 * 1024.0));
+
+	if (g_gc_precise_classes > 0)
+	{
+		fprintf(stderr, "GC: objects of %i classes scanned precisely using their layouts\n", g_gc_precise_classes);
+	}
+	else
+	{
+		fprintf(stderr, "GC: objects scanned conservatively\n");
+	}
+
+	if (lsGCPauses.Count > 0)
+	{
+		fprintf(stderr, "GC: %i pauses, %.2f ms total, %.2f ms average, %.2f ms longest\n",
+			lsGCPauses.Count,
+			lsGCPauses.TotalTime,
+			lsGCPauses.TotalTime / lsGCPauses.Count,
+			lsGCPauses.MaxTime);
+
+		int limit = 1;
+		for (int i = 0; i < LS_GC_PAUSE_BUCKETS; i++, limit *= 2)
+		{
+			if (i < LS_GC_PAUSE_BUCKETS - 1)
+			{
+				fprintf(stderr, "GC:   < %4i ms: %i\n", limit, lsGCPauses.Histogram[i]);
+			}
+			else
+			{
+				fprintf(stderr, "GC:  >= %4i ms: %i\n", limit / 2, lsGCPauses.Histogram[i]);
+			}
+		}
+	}
+}
+
+// =========================================================================
+//	lsArrayStorage.
+// =========================================================================
+
+// -------------------------------------------------------------------------
+//	Releases the strings held in an arrays storage once it is collected.
+// -------------------------------------------------------------------------
+static void lsFinalizeStringStorage(void* obj, void* client_data)
+{
+	lsString* elements = static_cast<lsString*>(obj);
+	int		  length   = (int)(size_t)client_data;
+
+	for (int i = 0; i < length; i++)
+	{
+		elements[i].~lsString();
+	}
+}
+
+// Zero filled storage already holds empty strings, so nothing needs 
+// constructing.
+lsString* lsArrayStorage<lsString>::Allocate(int length)
+{
+	return static_cast<lsString*>(lsGCObject::GCAllocateBuffer(length * sizeof(lsString), true));
+}
+
+void lsArrayStorage<lsString>::RegisterFinalizer(lsString* elements, int length)
+{
+	if (length > 0)
+	{
+		GC_REGISTER_FINALIZER_NO_ORDER(elements, lsFinalizeStringStorage, (void*)(size_t)length, NULL, NULL);
+	}
 }
 
 // =========================================================================
@@ -415,3 +845,12 @@ lsString lsObject::ToString()
 	return "object";
 }
 
+// -------------------------------------------------------------------------
+//	Objects are equal only to themselves, and the collector never moves 
+//	them, so by default their address is used as their hash.
+// -------------------------------------------------------------------------
+int lsObject::GetHashCode()
+{
+	return (int)((size_t)this >> 4);
+}
+
@@ -17,11 +17,71 @@
 #include <cstring>
 #include <cstdlib>
 #include <cstdarg>
+#include <cstddef>
 
 // Forward declarations.
 class lsString;
 template<typename T> class lsArray;
 
+// Number of buckets in the histogram of collection pauses. Bucket 0 counts
+// pauses shorter than 1ms, bucket n those shorter than 2^n ms and the last
+// bucket every pause longer than that.
+#define LS_GC_PAUSE_BUCKETS 10
+
+// -----------------------------------------------------------------------------
+//	Times of the collections the program has had to wait for, only recorded 
+//	while statistics are enabled. A collection is timed from when the 
+//	collector starts it to when the allocation that ran it returns. The
+//	steps of an incremental collector are not reported when they start, so 
+//	in that mode every allocation is timed instead.
+// -----------------------------------------------------------------------------
+struct lsGCPauseStats
+{
+	bool			Enabled;
+	bool			TimeAllocations;
+	volatile int	Collecting;
+	double			CollectionStart;
+	volatile int	Lock;
+	int				Count;
+	double			TotalTime;
+	double			MaxTime;
+	int				Histogram[LS_GC_PAUSE_BUCKETS];
+};
+
+extern lsGCPauseStats lsGCPauses;
+
+// -----------------------------------------------------------------------------
+//	Describes which words of a class can hold references to garbage collected
+//	memory, so the collector scans only those words of its instances instead
+//	of treating every integer and float as a possible pointer. Translated 
+//	classes build one the first time they are allocated, passing a function
+//	that adds the offset of each of their reference fields.
+// -----------------------------------------------------------------------------
+class lsGCLayout
+{
+private:
+	size_t* m_bitmap;
+	int		m_words;
+	bool	m_has_references;
+	size_t	m_descriptor;
+
+public:
+	lsGCLayout(int size, void (*describe)(lsGCLayout* layout));
+
+	void AddReference(size_t offset);
+
+	bool HasReferences() const
+	{
+		return m_has_references;
+	}
+
+	size_t GetDescriptor() const
+	{
+		return m_descriptor;
+	}
+
+};
+
 // -----------------------------------------------------------------------------
 //	All objects that derive from this class are garbage collected.
 // -----------------------------------------------------------------------------
@@ -36,20 +96,92 @@ public:
 	void  operator delete				(void* ptr);		
 	
 	static lsGCObject* 	GCAllocate		(int size);
+	static lsGCObject* 	GCAllocateTyped	(int size, const lsGCLayout* layout);
+	static void* 		GCAllocateBuffer(int size, bool atomic);
 	static void 		GCCollect		(bool full);	
+	static void			GCInit			(bool incremental);
+	static void			GCPrintStats	();
 	
 };
 
 // -----------------------------------------------------------------------------
 //	All objects derive from the base object class.
 // -----------------------------------------------------------------------------
-class lsObject : public virtual lsGCObject
+class lsObject : public lsGCObject
 {
 public:
+	int lsTypeID;
+
+	lsObject() : lsTypeID(0)
+	{
+	}
+
 	virtual lsString ToString();
-	
+	virtual int GetHashCode();
+
 };
 
+// -----------------------------------------------------------------------------
+//	Returns the address of a temporary object. Used for objects the compiler
+//	knows are not referenced once the expression creating them has finished,
+//	so they can live on the stack rather than the garbage collected heap.
+// -----------------------------------------------------------------------------
+template<typename T>
+T* lsStackTemporary(T&& value)
+{
+	return &value;
+}
+
+// -----------------------------------------------------------------------------
+//	Atomic operations on integers that are shared between threads. Each 
+//	returns the value the integer held before it was modified.
+// -----------------------------------------------------------------------------
+#ifdef _WIN32
+
+#include <intrin.h>
+
+inline int lsAtomicAdd(volatile int* value, int amount)
+{
+	return _InterlockedExchangeAdd((volatile long*)value, amount);
+}
+
+inline int lsAtomicExchange(volatile int* value, int new_value)
+{
+	return _InterlockedExchange((volatile long*)value, new_value);
+}
+
+inline int lsAtomicCompareExchange(volatile int* value, int expected, int new_value)
+{
+	return _InterlockedCompareExchange((volatile long*)value, new_value, expected);
+}
+
+#else
+
+inline int lsAtomicAdd(volatile int* value, int amount)
+{
+	return __sync_fetch_and_add(value, amount);
+}
+
+inline int lsAtomicExchange(volatile int* value, int new_value)
+{
+	__sync_synchronize();
+	return __sync_lock_test_and_set(value, new_value);
+}
+
+inline int lsAtomicCompareExchange(volatile int* value, int expected, int new_value)
+{
+	return __sync_val_compare_and_swap(value, expected, new_value);
+}
+
+#endif
+
+// -----------------------------------------------------------------------------
+//	Set when the program starts its first thread, and never cleared. Until 
+//	then shared state such as reference counts can be updated without 
+//	atomic operations.
+// -----------------------------------------------------------------------------
+extern bool lsMultiThreaded;
+
 // -----------------------------------------------------------------------------
 //	Used as an internal reference-counted representation of a strings character
 //	buffer.
@@ -57,12 +189,26 @@ public:
 class lsStringBuffer
 {
 private:
-	int m_ref_count;
+	volatile int m_ref_count;
 
 public:
 	char*			Buffer;
 	int				Length;
 
+	// Hash of the buffers contents, calculated the first time it is asked
+	// for. Zero until then.
+	int				Hash;
+
+	// Called instead of deleting the characters once the last reference is
+	// released, for buffers whose characters were not allocated by us, 
+	// such as memory mapped files. NULL for all others.
+	void			(*Free)(lsStringBuffer* buffer);
+
+	// Buffer the characters belong to, for buffers that use the end of 
+	// another buffers characters. It is released instead of the characters
+	// being freed. NULL for all others.
+	lsStringBuffer*	Owner;
+
 	lsStringBuffer();
 	
 	void Release();
@@ -80,11 +226,36 @@ public:
 //	the actual character buffer and uses reference counting to determine its
 //	lifecycle. This has significant performance benefits over cluttering up
 //	the GC with string instances.
+//
+//	Strings no longer than LS_STRING_INLINE_LENGTH store their characters
+//	inside the string itself instead, so short strings such as single 
+//	characters never allocate a buffer at all.
 // -----------------------------------------------------------------------------
+#define LS_STRING_INLINE_LENGTH 15
+
 class lsString
 {
 private:
-	lsStringBuffer* m_buffer;
+	union
+	{
+		lsStringBuffer* m_buffer;
+		char			m_inline[LS_STRING_INLINE_LENGTH + 1];
+	};
+	int m_length;
+
+	char* Reserve(int length);
+
+	static int CalculateHash(const char* buffer, int length);
+
+	bool IsInline() const
+	{
+		return m_length <= LS_STRING_INLINE_LENGTH;
+	}
+
+	const char* GetBuffer() const
+	{
+		return IsInline() ? m_inline : m_buffer->Buffer;
+	}
 	
 public:
 
@@ -105,7 +276,12 @@ public:
 	// -------------------------------------------------------------------------
 	//	Properties.
 	// -------------------------------------------------------------------------
-	int Length() const;
+	int Length() const
+	{
+		return m_length;
+	}
+	int CharAt(int index) const;
+	int GetHashCode() const;
 	lsString GetIndex(int index) const;
 	lsString GetSlice(int start_pos) const;
 	lsString GetSlice(int start_pos, int end_pos) const;
@@ -145,6 +321,27 @@ public:
 // -----------------------------------------------------------------------------
 #include "Packages/Native/CPP/Default/Compiler/Support/Exceptions.hpp"
 
+// -----------------------------------------------------------------------------
+//	Reads a single character without constructing a string to hold it. 
+//	Translated code uses this in place of GetIndex wherever only the 
+//	characters value is needed.
+// -----------------------------------------------------------------------------
+inline int lsString::CharAt(int index) const
+{
+#ifdef _DEBUG
+	if (index < 0 || index >= m_length)
+	{
+		throw lsOutOfBoundsException();		
+	}
+#endif
+	return GetBuffer()[index];
+}
+
+inline char lsString::operator [](int index) const
+{
+	return (char)CharAt(index);
+}
+
 // -----------------------------------------------------------------------------
 //	This function is responsible for determening if an object can be cast
 //	to another type of object at runtime. Invoked when either upcasting or 
@@ -161,6 +358,108 @@ ToType lsCast(FromType val, bool throw_error_on_fail)
 	return result;
 }
 
+// -----------------------------------------------------------------------------
+//	Casts an object to a translated class. Each translated class is given a 
+//	range of type ids covering itself and every class derived from it, so 
+//	this only needs to compare the objects id against that range.
+// -----------------------------------------------------------------------------
+template<typename ToClass, typename FromType>
+ToClass* lsClassCast(FromType val, bool throw_error_on_fail)
+{
+	if (val != NULL &&
+		val->lsTypeID >= ToClass::lsTypeFirst &&
+		val->lsTypeID <= ToClass::lsTypeLast)
+	{
+		return static_cast<ToClass*>(val);
+	}
+	if (throw_error_on_fail == true)
+	{
+		throw new lsInvalidCastException();
+	}	
+	return NULL;
+}
+
+// -----------------------------------------------------------------------------
+//	Allocates the element storage of arrays from the garbage collector. 
+//	Storage is always zero filled. Elements that can reference garbage 
+//	collected objects are scanned by the collector, primitive elements are
+//	stored in atomic memory that it never scans.
+//
+//	Registering a finalizer makes allocating storage several times slower,
+//	so storage is only given one once an element that has to be released
+//	is stored in it, see NeedsFinalizer.
+// -----------------------------------------------------------------------------
+template<typename T>
+struct lsArrayStorage
+{
+	static T* Allocate(int length)
+	{
+		return static_cast<T*>(lsGCObject::GCAllocateBuffer(length * sizeof(T), false));
+	}
+	
+	static bool IsZero(const T& value)
+	{
+		return value == NULL;
+	}
+
+	static bool NeedsFinalizer(const T& value)
+	{
+		return false;
+	}
+
+	static void RegisterFinalizer(T* elements, int length)
+	{
+	}
+};
+
+template<typename T>
+struct lsAtomicArrayStorage
+{
+	static T* Allocate(int length)
+	{
+		return static_cast<T*>(lsGCObject::GCAllocateBuffer(length * sizeof(T), true));
+	}
+	
+	static bool IsZero(const T& value)
+	{
+		return value == 0;
+	}
+
+	static bool NeedsFinalizer(const T& value)
+	{
+		return false;
+	}
+
+	static void RegisterFinalizer(T* elements, int length)
+	{
+	}
+};
+
+template<> struct lsArrayStorage<int>	: public lsAtomicArrayStorage<int>		{ };
+template<> struct lsArrayStorage<float> : public lsAtomicArrayStorage<float>	{ };
+template<> struct lsArrayStorage<bool>	: public lsAtomicArrayStorage<bool>		{ };
+
+// Strings hold no garbage collected references. Zero filled memory is an 
+// empty string, but strings too long to be stored inline hold a buffer that
+// has to be released when the storage is collected.
+template<>
+struct lsArrayStorage<lsString>
+{
+	static lsString* Allocate(int length);
+	
+	static bool IsZero(const lsString& value)
+	{
+		return value.Length() == 0;
+	}
+
+	static bool NeedsFinalizer(const lsString& value)
+	{
+		return value.Length() > LS_STRING_INLINE_LENGTH;
+	}
+
+	static void RegisterFinalizer(lsString* elements, int length);
+};
+
 // -----------------------------------------------------------------------------
 //	The array is a special class that all arrays are derived from. Arrays do
 //	not derive themselves from object and are handled differently. This class
@@ -174,6 +473,18 @@ private:
 	T   m_default;
 	T*  m_buffer;
 	int m_length;
+	bool m_finalized;
+
+	// Gives the storage a finalizer the first time a value that needs 
+	// releasing is stored in it.
+	void Store(const T& value)
+	{
+		if (m_finalized == false && lsArrayStorage<T>::NeedsFinalizer(value) == true)
+		{
+			lsArrayStorage<T>::RegisterFinalizer(m_buffer, m_length);
+			m_finalized = true;
+		}
+	}
 	
 public:
 
@@ -182,20 +493,27 @@ public:
 	// -------------------------------------------------------------------------
 	virtual ~lsArray()
 	{
-		delete[] m_buffer;
-		m_buffer = NULL;
 	}
 	
 	lsArray(int size) :
+		m_default(),
 		m_length(size),
-		m_buffer(new T[size])
+		m_buffer(lsArrayStorage<T>::Allocate(size)),
+		m_finalized(false)
 	{
 	}
 	
 	lsArray(lsArray<T>* other, int offset, int length) :
+		m_default(other->m_default),
 		m_length(length),
-		m_buffer(new T[length])
+		m_buffer(lsArrayStorage<T>::Allocate(length)),
+		m_finalized(false)
 	{
+		if (other->m_finalized == true)
+		{
+			lsArrayStorage<T>::RegisterFinalizer(m_buffer, m_length);
+			m_finalized = true;
+		}
 		for (int i = offset; i < offset + length; i++)
 		{
 			m_buffer[i - offset] = other->m_buffer[i];
@@ -203,20 +521,32 @@ public:
 	}
 	
 	lsArray(lsArray<T>* other) :
+		m_default(other->m_default),
 		m_length(other->m_length),
-		m_buffer(new T[other->m_length])
+		m_buffer(lsArrayStorage<T>::Allocate(other->m_length)),
+		m_finalized(false)
 	{	
+		if (other->m_finalized == true)
+		{
+			lsArrayStorage<T>::RegisterFinalizer(m_buffer, m_length);
+			m_finalized = true;
+		}
 		for (int i = 0; i < other->m_length; i++)
 		{
 			m_buffer[i] = other->m_buffer[i];
 		}	
 	}
 
+	// Storage is already zero filled, so it only needs writing for other values.
 	lsArray* Init(T value)
 	{
-		for (int i = 0; i < m_length; i++)
+		Store(value);
+		if (lsArrayStorage<T>::IsZero(value) == false)
 		{
-			m_buffer[i] = value;
+			for (int i = 0; i < m_length; i++)
+			{
+				m_buffer[i] = value;
+			}
 		}
 		m_default = value;
 		return this;
@@ -232,43 +562,58 @@ public:
 	
 	void Resize(int size)
 	{
-		T* new_buffer = new T[size];
-		for (int i = 0; i < size; i++)
+		T* new_buffer = lsArrayStorage<T>::Allocate(size);
+		if (m_finalized == true)
 		{
-			if (i < m_length)
-			{
-				new_buffer[i] = m_buffer[i];
-			}
-			else
+			lsArrayStorage<T>::RegisterFinalizer(new_buffer, size);
+		}
+		for (int i = 0; i < m_length && i < size; i++)
+		{
+			new_buffer[i] = m_buffer[i];
+		}
+		if (lsArrayStorage<T>::IsZero(m_default) == false)
+		{
+			for (int i = m_length; i < size; i++)
 			{
 				new_buffer[i] = m_default;
 			}
 		}
 		
-		delete[] m_buffer;
 		m_buffer = new_buffer;
 		m_length = size;
 	}
 
+	// Indexes are always bounds checked here. When checks are disabled, or
+	// the translator can prove an index is in bounds, it reads the buffer
+	// directly and sets elements with SetIndexUnchecked instead.
+	T* GetBuffer() const
+	{
+		return m_buffer;
+	}
+
+	T SetIndexUnchecked(int index, T value)
+	{
+		Store(value);
+		m_buffer[index] = value;
+		return value;
+	}
+
 	T GetIndex(int index) const
 	{
-#ifdef _DEBUG
 		if (index < 0 || index >= m_length)
 		{
 			throw new lsOutOfBoundsException();		
 		}
-#endif
 		return m_buffer[index];
 	}
 	
 	T SetIndex(int index, T value, bool postfix = false)
 	{
-#ifdef _DEBUG
 		if (index < 0 || index >= m_length)
 		{
 			throw new lsOutOfBoundsException();		
 		}
-#endif
+		Store(value);
 		T old_value = m_buffer[index];
 		m_buffer[index] = value;
 		
@@ -284,12 +629,10 @@ public:
 	
 	void ClearIndex(int index)
 	{
-#ifdef _DEBUG
 		if (index < 0 || index >= m_length)
 		{
 			throw new lsOutOfBoundsException();		
 		}
-#endif
 		m_buffer[index] = m_default;
 	}
 	
@@ -348,6 +691,18 @@ public:
 	
 };
 
+// -----------------------------------------------------------------------------
+//	Assigns a value to an unchecked array element and returns the value it 
+//	previously held, used for postfix increments and decrements.
+// -----------------------------------------------------------------------------
+template<typename T>
+T lsSetPostfix(T& element, T value)
+{
+	T old_value = element;
+	element = value;
+	return old_value;
+}
+
 // -----------------------------------------------------------------------------
 //	Used to construct an array from an initialization list.
 // -----------------------------------------------------------------------------
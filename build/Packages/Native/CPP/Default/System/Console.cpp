@@ -3,31 +3,158 @@
 // 	Copyright (C) 2012-2013 TwinDrills, All Rights Reserved
 // -----------------------------------------------------------------------------
 //	This package contains code required to interact with the console.
+//
+//	Output is written through stdout, so it shares its buffer with anything
+//	else the program prints and is flushed by the C runtime when the 
+//	program exits. While the console is a terminal stdout is left line 
+//	buffered so output appears as it is written, otherwise it is given a 
+//	larger buffer that is only written out when full or flushed.
 // -----------------------------------------------------------------------------
 
 #include "Packages/Native/CPP/Default/System/Console.hpp"
 
+#ifdef _WIN32
+#include <io.h>
+#define isatty _isatty
+#define fileno _fileno
+#else
+#include <unistd.h>
+#endif
+
+// Writes to stdout while it is already locked by the calling thread.
+#if defined(_WIN32)
+#define LS_CONSOLE_LOCK()				_lock_file(stdout)
+#define LS_CONSOLE_UNLOCK()				_unlock_file(stdout)
+#define LS_CONSOLE_WRITE(data, length)	_fwrite_nolock(data, 1, length, stdout)
+#define LS_CONSOLE_PUTC(chr)			_fputc_nolock(chr, stdout)
+#elif defined(__GLIBC__)
+#define LS_CONSOLE_LOCK()				flockfile(stdout)
+#define LS_CONSOLE_UNLOCK()				funlockfile(stdout)
+#define LS_CONSOLE_WRITE(data, length)	fwrite_unlocked(data, 1, length, stdout)
+#define LS_CONSOLE_PUTC(chr)			putc_unlocked(chr, stdout)
+#else
+#define LS_CONSOLE_LOCK()				flockfile(stdout)
+#define LS_CONSOLE_UNLOCK()				funlockfile(stdout)
+#define LS_CONSOLE_WRITE(data, length)	fwrite(data, 1, length, stdout)
+#define LS_CONSOLE_PUTC(chr)			putc_unlocked(chr, stdout)
+#endif
+
+// -----------------------------------------------------------------------------
+//	Gives stdout its buffer before anything is written to it.
+// -----------------------------------------------------------------------------
+struct lsConsoleInitializer
+{
+	lsConsoleInitializer()
+	{
+		if (isatty(fileno(stdout)) == 0)
+		{
+			lsConsole::SetBufferSize(LS_CONSOLE_DEFAULT_BUFFER_SIZE);
+		}
+	}
+};
+
+static lsConsoleInitializer g_console_initializer;
+
+// Buffer given to stdout by SetBufferSize, NULL while it has none of ours.
+static char* g_console_buffer = NULL;
+
 // -----------------------------------------------------------------------------
 //	Writes a string of text to the console.
 // -----------------------------------------------------------------------------
 void lsConsole::Write(lsString output)
 {
-	printf("%s", output.ToCString());
+	WriteRaw(output.ToCString(), output.Length());
 }
 
 // -----------------------------------------------------------------------------
-//	Writes a string of text to the console and appends a new line.
+//	Writes a string of text to the console and appends a new line. The 
+//	stream is locked so lines written by different threads don't mix.
 // -----------------------------------------------------------------------------
 void lsConsole::WriteLine(lsString output)
 {
-	printf("%s\n", output.ToCString());
+	LS_CONSOLE_LOCK();
+	LS_CONSOLE_WRITE(output.ToCString(), output.Length());
+	LS_CONSOLE_PUTC('\n');
+	LS_CONSOLE_UNLOCK();
+}
+
+// -----------------------------------------------------------------------------
+//	Writes characters to the console as they are.
+// -----------------------------------------------------------------------------
+void lsConsole::WriteRaw(const char* data, int length)
+{
+	fwrite(data, 1, length, stdout);
+}
+
+// -----------------------------------------------------------------------------
+//	Writes count elements of the array from the offset given, one byte for
+//	each element.
+// -----------------------------------------------------------------------------
+void lsConsole::WriteRaw(lsArray<int>* buffer, int offset, int count)
+{
+	if (offset < 0 || count < 0 || offset + count > buffer->Length())
+	{
+		throw new lsOutOfBoundsException();
+	}
+
+	int* input = buffer->GetBuffer() + offset;
+
+	LS_CONSOLE_LOCK();
+	for (int i = 0; i < count; i++)
+	{
+		LS_CONSOLE_PUTC((char)input[i]);
+	}
+	LS_CONSOLE_UNLOCK();
+}
+
+// -----------------------------------------------------------------------------
+//	Writes any buffered output to the console.
+// -----------------------------------------------------------------------------
+void lsConsole::Flush()
+{
+	fflush(stdout);
+}
+
+// -----------------------------------------------------------------------------
+//	Sets the size of the buffer output is held in until it is flushed. The
+//	C runtime can ignore the size of a buffer it allocates itself, so we 
+//	always provide it. The previous buffer is only freed once stdout has
+//	stopped using it.
+// -----------------------------------------------------------------------------
+void lsConsole::SetBufferSize(int size)
+{
+	fflush(stdout);
+
+	char* buffer = NULL;
+	int	  result = 0;
+
+	if (size <= 0)
+	{
+		result = setvbuf(stdout, NULL, _IONBF, 0);
+	}
+	else
+	{
+		buffer = (char*)malloc(size);
+		result = setvbuf(stdout, buffer, _IOFBF, size);
+	}
+
+	if (result != 0)
+	{
+		free(buffer);
+		return;
+	}
+
+	free(g_console_buffer);
+	g_console_buffer = buffer;
 }
 
 // -----------------------------------------------------------------------------
 //	Reads next character from console. Blocks until character available.
+//	Output is flushed first so any prompt is shown.
 // -----------------------------------------------------------------------------
 int lsConsole::ReadChar()
 {
+	fflush(stdout);
 	return getchar();
 }
 
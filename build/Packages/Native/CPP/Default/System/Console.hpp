@@ -10,6 +10,10 @@
 
 #include "Packages/Native/CPP/Default/Compiler/Support/Types.hpp"
 
+// Size of the buffer output is held in until it is flushed, when the
+// console is not a terminal.
+#define LS_CONSOLE_DEFAULT_BUFFER_SIZE (64 * 1024)
+
 // -----------------------------------------------------------------------------
 //	Used as a base for all objects which can be thrown.
 // -----------------------------------------------------------------------------
@@ -27,6 +31,30 @@ public:
 	// -------------------------------------------------------------------------
 	static void WriteLine	(lsString output);
 
+	// -------------------------------------------------------------------------
+	//	Writes characters to the console as they are, without needing them
+	//	to be null terminated.
+	// -------------------------------------------------------------------------
+	static void WriteRaw	(const char* data, int length);
+
+	// -------------------------------------------------------------------------
+	//	Writes count elements of the array from the offset given, one byte 
+	//	for each element.
+	// -------------------------------------------------------------------------
+	static void WriteRaw	(lsArray<int>* buffer, int offset, int count);
+
+	// -------------------------------------------------------------------------
+	//	Writes any buffered output to the console.
+	// -------------------------------------------------------------------------
+	static void Flush		();
+
+	// -------------------------------------------------------------------------
+	//	Sets the size of the buffer output is held in until it is flushed. 
+	//	0 writes output as soon as it is given. Any output already buffered 
+	//	is flushed first.
+	// -------------------------------------------------------------------------
+	static void SetBufferSize(int size);
+
 	// -------------------------------------------------------------------------
 	//  Reads a character from the console. Blocks if character is not available.
 	// -------------------------------------------------------------------------
@@ -23,6 +23,8 @@
 
 #endif
 
+#include <string>
+
 #include "Packages/Native/CPP/Default/Compiler/Support/Types.hpp"
 #include "Packages/Native/CPP/Default/System/File.hpp"
 #include "Packages/Native/CPP/Default/System/Path.hpp"
@@ -168,42 +170,33 @@ lsString lsFile::LoadText(lsString path)
 		return "";
 	}
 
-	lsString output = "";
-	while (!feof(file))
+	// Read the whole file before building the string, appending to
+	// a string one character at a time copies it for every character.
+	std::string contents;
+	char buffer[4096];
+	while (true)
 	{
-		int c = fgetc(file);
-		if (c != EOF)
+		int read = fread(buffer, 1, sizeof(buffer), file);
+		if (read <= 0)
 		{
-			// Patch up \r\n newlines into simply \n
-			if (c == '\r')
-			{
-				int c2 = fgetc(file);
-				if (c2 == '\n')
-				{
-					output += (char)c2;
-				}
-				else
-				{					
-					output += (char)c;
-					if (c2 != EOF)
-					{
-						output += (char)c2;
-					}
-					else
-					{
-						break;
-					}
-				}
-			}
-			else
-			{
-				output += (char)c;
-			}
+			break;
 		}
+		contents.append(buffer, read);
 	}
-
 	fclose(file);
-	return output;
+
+	// Patch up \r\n newlines into simply \n
+	int length = 0;
+	for (int i = 0; i < (int)contents.size(); i++)
+	{
+		if (contents[i] == '\r' && i + 1 < (int)contents.size() && contents[i + 1] == '\n')
+		{
+			continue;
+		}
+		contents[length++] = contents[i];
+	}
+
+	return lsString(contents.c_str(), length);
 }
 
 void lsFile::SaveText(lsString path, lsString value)
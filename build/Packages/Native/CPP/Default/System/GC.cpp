@@ -9,6 +9,17 @@
 
 #include "Packages/Native/CPP/Default/System/GC/include/gc.h"
 
+#include <limits.h>
+
+// -------------------------------------------------------------------------
+//  Converts a number of bytes to an int, sizes too large to fit are 
+//	returned as the largest int.
+// -------------------------------------------------------------------------
+static int lsGCClampBytes(GC_word bytes)
+{
+	return bytes > (GC_word)INT_MAX ? INT_MAX : (int)bytes;
+}
+
 // -------------------------------------------------------------------------
 //  Runs a garbage collection cycle. If full is true then all garbage will
 //	be collected, if false then garbage will be collected incrementally.
@@ -23,5 +34,104 @@ void lsGC::Collect(bool full)
 // -------------------------------------------------------------------------
 int lsGC::GetBytesAllocated()
 {
-	return GC_get_total_bytes();
+	return lsGCClampBytes(GC_get_total_bytes());
+}
+
+// -------------------------------------------------------------------------
+//  Gets the number of collections run so far.
+// -------------------------------------------------------------------------
+int lsGC::GetCollectionCount()
+{
+	return (int)GC_get_gc_no();
+}
+
+// -------------------------------------------------------------------------
+//  Gets the size of the heap.
+// -------------------------------------------------------------------------
+int lsGC::GetHeapSize()
+{
+	GC_word heap_size = 0;
+	GC_get_heap_usage_safe(&heap_size, NULL, NULL, NULL, NULL);
+	return lsGCClampBytes(heap_size);
+}
+
+// -------------------------------------------------------------------------
+//  Gets the number of bytes in the heap that are free.
+// -------------------------------------------------------------------------
+int lsGC::GetFreeBytes()
+{
+	GC_word free_bytes = 0;
+	GC_get_heap_usage_safe(NULL, &free_bytes, NULL, NULL, NULL);
+	return lsGCClampBytes(free_bytes);
+}
+
+// -------------------------------------------------------------------------
+//  Gets the number of bytes allocated since the last collection.
+// -------------------------------------------------------------------------
+int lsGC::GetBytesSinceCollection()
+{
+	GC_word bytes_since_gc = 0;
+	GC_get_heap_usage_safe(NULL, NULL, NULL, &bytes_since_gc, NULL);
+	return lsGCClampBytes(bytes_since_gc);
+}
+
+// -------------------------------------------------------------------------
+//  Starts or stops recording the time of collections.
+// -------------------------------------------------------------------------
+void lsGC::EnableStats(bool enabled)
+{
+	lsGCPauses.Enabled = enabled;
+}
+
+// -------------------------------------------------------------------------
+//  Returns true if the time of collections is being recorded.
+// -------------------------------------------------------------------------
+bool lsGC::IsStatsEnabled()
+{
+	return lsGCPauses.Enabled;
+}
+
+// -------------------------------------------------------------------------
+//  Gets the number of pauses recorded.
+// -------------------------------------------------------------------------
+int lsGC::GetPauseCount()
+{
+	return lsGCPauses.Count;
+}
+
+// -------------------------------------------------------------------------
+//  Gets the total time of the pauses recorded in milliseconds.
+// -------------------------------------------------------------------------
+float lsGC::GetTotalPauseTime()
+{
+	return (float)lsGCPauses.TotalTime;
+}
+
+// -------------------------------------------------------------------------
+//  Gets the time of the longest pause recorded in milliseconds.
+// -------------------------------------------------------------------------
+float lsGC::GetMaxPauseTime()
+{
+	return (float)lsGCPauses.MaxTime;
+}
+
+// -------------------------------------------------------------------------
+//  Gets the number of pauses recorded in each bucket of the histogram.
+// -------------------------------------------------------------------------
+lsArray<int>* lsGC::GetPauseHistogram()
+{
+	lsArray<int>* histogram = new lsArray<int>(LS_GC_PAUSE_BUCKETS);
+	for (int i = 0; i < LS_GC_PAUSE_BUCKETS; i++)
+	{
+		histogram->SetIndex(i, lsGCPauses.Histogram[i]);
+	}
+	return histogram;
+}
+
+// -------------------------------------------------------------------------
+//  Writes a summary of the statistics to stderr.
+// -------------------------------------------------------------------------
+void lsGC::PrintStats()
+{
+	lsGCObject::GCPrintStats();
 }
\ No newline at end of file
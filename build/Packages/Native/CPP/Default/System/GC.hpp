@@ -24,10 +24,52 @@ public:
 	static void Collect(bool full);
 	
 	// -------------------------------------------------------------------------
-	//  Gets the number of bytes currently allocated.
+	//  Gets the number of bytes currently allocated. Like the other sizes
+	//	below, values over 2GB are returned as the largest int.
 	// -------------------------------------------------------------------------
 	static int GetBytesAllocated();
 
+	// -------------------------------------------------------------------------
+	//  Gets the number of collections run so far.
+	// -------------------------------------------------------------------------
+	static int GetCollectionCount();
+
+	// -------------------------------------------------------------------------
+	//  Gets the size of the heap, the number of bytes in it that are free, and
+	//	the number of bytes allocated since the last collection.
+	// -------------------------------------------------------------------------
+	static int GetHeapSize();
+	static int GetFreeBytes();
+	static int GetBytesSinceCollection();
+
+	// -------------------------------------------------------------------------
+	//  Starts or stops recording the time of collections the program waits
+	//	for. Recording times every allocation, so it is off unless enabled
+	//	here or by running the program with LS_GC_STATS=1.
+	// -------------------------------------------------------------------------
+	static void EnableStats(bool enabled);
+	static bool IsStatsEnabled();
+
+	// -------------------------------------------------------------------------
+	//  Gets the number of pauses recorded and their total and longest time
+	//	in milliseconds.
+	// -------------------------------------------------------------------------
+	static int	 GetPauseCount();
+	static float GetTotalPauseTime();
+	static float GetMaxPauseTime();
+
+	// -------------------------------------------------------------------------
+	//  Gets the number of pauses recorded in each bucket of the histogram.
+	//	Bucket 0 counts pauses shorter than 1ms, bucket n those shorter than 
+	//	2^n ms and the last bucket every pause longer than that.
+	// -------------------------------------------------------------------------
+	static lsArray<int>* GetPauseHistogram();
+
+	// -------------------------------------------------------------------------
+	//  Writes a summary of the statistics to stderr.
+	// -------------------------------------------------------------------------
+	static void PrintStats();
+
 };
 
 #endif // __LS_PACKAGES_NATIVE_WIN32_SYSTEM_GC__
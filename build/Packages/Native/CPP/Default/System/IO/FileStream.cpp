@@ -0,0 +1,1098 @@
+// -----------------------------------------------------------------------------
+// 	filestream.cpp
+// 	Copyright (C) 2012-2013 TwinDrills, All Rights Reserved
+// -----------------------------------------------------------------------------
+//	This package contains the code used to read and write files a piece at
+//	a time.
+// -----------------------------------------------------------------------------
+
+#ifdef _WIN32
+
+#include <Windows.h>
+#include <io.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#else defined(__linux__) || defined(__APPLE__)
+
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+
+#endif
+
+#include <climits>
+#include <cerrno>
+
+#include "Packages/Native/CPP/Default/System/IO/FileStream.hpp"
+#include "Packages/Native/CPP/Default/System/GC/include/gc.h"
+
+// Modes files can be opened with, these match the values of FileMode.
+#define LS_FILE_MODE_READ		1
+#define LS_FILE_MODE_WRITE		2
+#define LS_FILE_MODE_APPEND		3
+#define LS_FILE_MODE_READ_WRITE	4
+
+// Positions files can be seeked from, these match the values of SeekOrigin.
+#define LS_SEEK_ORIGIN_BEGIN	0
+#define LS_SEEK_ORIGIN_CURRENT	1
+#define LS_SEEK_ORIGIN_END		2
+
+// =========================================================================
+//	OS file handles.
+// =========================================================================
+
+static int lsFileHandleOpen(const char* path, int mode)
+{
+	int flags = 0;
+	switch (mode)
+	{
+		case LS_FILE_MODE_READ:			flags = O_RDONLY;							break;
+		case LS_FILE_MODE_WRITE:		flags = O_WRONLY | O_CREAT | O_TRUNC;		break;
+		case LS_FILE_MODE_APPEND:		flags = O_WRONLY | O_CREAT | O_APPEND;		break;
+		case LS_FILE_MODE_READ_WRITE:	flags = O_RDWR | O_CREAT;					break;
+		default:						return -1;
+	}
+#ifdef _WIN32
+	return _open(path, flags | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+	return open(path, flags, 0666);
+#endif
+}
+
+static void lsFileHandleClose(int handle)
+{
+#ifdef _WIN32
+	_close(handle);
+#else
+	close(handle);
+#endif
+}
+
+static int lsFileHandleRead(int handle, char* buffer, int count)
+{
+#ifdef _WIN32
+	return _read(handle, buffer, count);
+#else
+	while (true)
+	{
+		int result = read(handle, buffer, count);
+		if (result >= 0 || errno != EINTR)
+		{
+			return result;
+		}
+	}
+#endif
+}
+
+// -------------------------------------------------------------------------
+//	Writes every byte given, returns false if any could not be written.
+// -------------------------------------------------------------------------
+static bool lsFileHandleWrite(int handle, const char* buffer, int count)
+{
+	while (count > 0)
+	{
+#ifdef _WIN32
+		int result = _write(handle, buffer, count);
+#else
+		int result = write(handle, buffer, count);
+		if (result < 0 && errno == EINTR)
+		{
+			continue;
+		}
+#endif
+		if (result <= 0)
+		{
+			return false;
+		}
+		buffer += result;
+		count  -= result;
+	}
+	return true;
+}
+
+static long long lsFileHandleSeek(int handle, long long offset, int origin)
+{
+#ifdef _WIN32
+	return _lseeki64(handle, offset, origin);
+#else
+	return lseek(handle, offset, origin);
+#endif
+}
+
+static long long lsFileHandleLength(int handle)
+{
+#ifdef _WIN32
+	return _filelengthi64(handle);
+#else
+	struct stat info;
+	if (fstat(handle, &info) != 0)
+	{
+		return -1;
+	}
+	return info.st_size;
+#endif
+}
+
+// =========================================================================
+//	Open streams.
+// =========================================================================
+
+// Streams with a file open, so anything still in their buffers can be 
+// written out when the program exits. The links are hidden from the 
+// collector, so streams that are never closed can still be collected.
+static GC_hidden_pointer	g_open_streams		= 0;
+static volatile int			g_open_streams_lock	= 0;
+static bool					g_open_streams_exit	= false;
+
+static void lsFileStreamLockOpen()
+{
+	while (lsAtomicCompareExchange(&g_open_streams_lock, 0, 1) != 0)
+	{
+	}
+}
+
+static void lsFileStreamUnlockOpen()
+{
+	lsAtomicExchange(&g_open_streams_lock, 0);
+}
+
+// -------------------------------------------------------------------------
+//	Flushes every stream still open when the program exits.
+// -------------------------------------------------------------------------
+void lsFileStream::FlushOpen()
+{
+	lsFileStreamLockOpen();
+	for (GC_hidden_pointer link = g_open_streams; link != 0; )
+	{
+		lsFileStream* stream = static_cast<lsFileStream*>(GC_REVEAL_POINTER(link));
+		stream->FlushWrites();
+		link = stream->m_next_open;
+	}
+	lsFileStreamUnlockOpen();
+}
+
+void lsFileStream::AddOpen()
+{
+	lsFileStreamLockOpen();
+	if (g_open_streams_exit == false)
+	{
+		atexit(&lsFileStream::FlushOpen);
+		g_open_streams_exit = true;
+	}
+	if (g_open_streams != 0)
+	{
+		static_cast<lsFileStream*>(GC_REVEAL_POINTER(g_open_streams))->m_prev_open = GC_HIDE_POINTER(this);
+	}
+	m_next_open		= g_open_streams;
+	m_prev_open		= 0;
+	g_open_streams	= GC_HIDE_POINTER(this);
+	lsFileStreamUnlockOpen();
+}
+
+void lsFileStream::RemoveOpen()
+{
+	lsFileStreamLockOpen();
+	if (m_prev_open != 0)
+	{
+		static_cast<lsFileStream*>(GC_REVEAL_POINTER(m_prev_open))->m_next_open = m_next_open;
+	}
+	else
+	{
+		g_open_streams = m_next_open;
+	}
+	if (m_next_open != 0)
+	{
+		static_cast<lsFileStream*>(GC_REVEAL_POINTER(m_next_open))->m_prev_open = m_prev_open;
+	}
+	m_next_open = 0;
+	m_prev_open = 0;
+	lsFileStreamUnlockOpen();
+}
+
+// =========================================================================
+//	lsFileStream.
+// =========================================================================
+lsFileStream::lsFileStream() :
+	m_handle(-1),
+	m_can_read(false),
+	m_can_write(false),
+	m_buffer(NULL),
+	m_buffer_size(LS_FILE_STREAM_DEFAULT_BUFFER_SIZE),
+	m_buffer_offset(0),
+	m_read_length(0),
+	m_read_position(0),
+	m_write_length(0),
+	m_next_open(0),
+	m_prev_open(0)
+{
+	GC_REGISTER_FINALIZER_NO_ORDER(this, &lsFileStream::Finalize, NULL, NULL, NULL);
+}
+
+// -------------------------------------------------------------------------
+//	Flushes and closes the file once the stream has been collected.
+// -------------------------------------------------------------------------
+void lsFileStream::Finalize(void* obj, void* client_data)
+{
+	lsFileStream* stream = static_cast<lsFileStream*>(obj);
+	if (stream->m_handle >= 0)
+	{
+		stream->RemoveOpen();
+		stream->FlushWrites();
+		lsFileHandleClose(stream->m_handle);
+	}
+	free(stream->m_buffer);
+}
+
+// -------------------------------------------------------------------------
+//	Writes out any bytes waiting in the buffer. Returns false if they could
+//	not all be written.
+// -------------------------------------------------------------------------
+bool lsFileStream::FlushWrites()
+{
+	if (m_write_length == 0)
+	{
+		return true;
+	}
+
+	bool result = lsFileHandleWrite(m_handle, m_buffer, m_write_length);
+	m_buffer_offset += m_write_length;
+	m_write_length = 0;
+
+	return result;
+}
+
+// -------------------------------------------------------------------------
+//	Throws away bytes read ahead of the position, moving the file back to
+//	the position so it can be written to.
+// -------------------------------------------------------------------------
+void lsFileStream::DiscardReads()
+{
+	if (m_read_length == 0)
+	{
+		return;
+	}
+
+	if (m_read_position != m_read_length)
+	{
+		lsFileHandleSeek(m_handle, m_buffer_offset + m_read_position, SEEK_SET);
+	}
+	m_buffer_offset += m_read_position;
+	m_read_length	= 0;
+	m_read_position = 0;
+}
+
+// -------------------------------------------------------------------------
+//	Reads the next block of the file into the buffer, once every byte
+//	already in it has been used. Returns false at the end of the file.
+// -------------------------------------------------------------------------
+bool lsFileStream::FillBuffer()
+{
+	if (m_can_read == false)
+	{
+		return false;
+	}
+	if (FlushWrites() == false)
+	{
+		throw new lsOperationFailedException();
+	}
+
+	m_buffer_offset += m_read_length;
+	m_read_length	= 0;
+	m_read_position = 0;
+
+	int result = lsFileHandleRead(m_handle, m_buffer, m_buffer_size);
+	if (result < 0)
+	{
+		throw new lsOperationFailedException();
+	}
+	m_read_length = result;
+
+	return (result > 0);
+}
+
+// -------------------------------------------------------------------------
+//	Opens the file at the given path, closing any file already open.
+//	Returns false if it could not be opened.
+// -------------------------------------------------------------------------
+bool lsFileStream::Open(lsString path, int mode)
+{
+	Close();
+
+	int handle = lsFileHandleOpen(path.ToCString(), mode);
+	if (handle < 0)
+	{
+		return false;
+	}
+
+	if (m_buffer == NULL)
+	{
+		m_buffer = (char*)malloc(m_buffer_size);
+		if (m_buffer == NULL)
+		{
+			lsFileHandleClose(handle);
+			throw new lsOutOfMemoryException();
+		}
+	}
+
+	m_handle		= handle;
+	m_can_read		= (mode == LS_FILE_MODE_READ || mode == LS_FILE_MODE_READ_WRITE);
+	m_can_write		= (mode != LS_FILE_MODE_READ);
+	m_buffer_offset = 0;
+	m_read_length	= 0;
+	m_read_position = 0;
+	m_write_length	= 0;
+
+	if (mode == LS_FILE_MODE_APPEND)
+	{
+		m_buffer_offset = lsFileHandleSeek(m_handle, 0, SEEK_END);
+	}
+
+	AddOpen();
+
+	return true;
+}
+
+// -------------------------------------------------------------------------
+//	Flushes anything written and closes the file.
+// -------------------------------------------------------------------------
+void lsFileStream::Close()
+{
+	if (m_handle < 0)
+	{
+		return;
+	}
+
+	RemoveOpen();
+
+	bool flushed = FlushWrites();
+	lsFileHandleClose(m_handle);
+
+	m_handle		= -1;
+	m_can_read		= false;
+	m_can_write		= false;
+	m_read_length	= 0;
+	m_read_position = 0;
+
+	if (flushed == false)
+	{
+		throw new lsOperationFailedException();
+	}
+}
+
+bool lsFileStream::IsOpen()
+{
+	return (m_handle >= 0);
+}
+
+// -------------------------------------------------------------------------
+//	Reads up to the given number of bytes, returning how many were read.
+//	Fewer are only returned at the end of the file. Reads at least as
+//	large as the buffer go straight into the destination.
+// -------------------------------------------------------------------------
+int lsFileStream::ReadBytes(char* buffer, int count)
+{
+	if (m_can_read == false)
+	{
+		throw new lsOperationFailedException();
+	}
+
+	int total = 0;
+	while (total < count)
+	{
+		int available = m_read_length - m_read_position;
+		if (available > 0)
+		{
+			int length = (count - total < available) ? count - total : available;
+			memcpy(buffer + total, m_buffer + m_read_position, length);
+			m_read_position += length;
+			total += length;
+			continue;
+		}
+
+		int remaining = count - total;
+		if (remaining >= m_buffer_size && m_write_length == 0)
+		{
+			m_buffer_offset += m_read_length;
+			m_read_length	= 0;
+			m_read_position = 0;
+
+			int result = lsFileHandleRead(m_handle, buffer + total, remaining);
+			if (result < 0)
+			{
+				throw new lsOperationFailedException();
+			}
+			if (result == 0)
+			{
+				break;
+			}
+			m_buffer_offset += result;
+			total += result;
+			continue;
+		}
+
+		if (FillBuffer() == false)
+		{
+			break;
+		}
+	}
+
+	return total;
+}
+
+// -------------------------------------------------------------------------
+//	Writes the given bytes. Writes at least as large as the buffer go
+//	straight to the file.
+// -------------------------------------------------------------------------
+void lsFileStream::WriteBytes(const char* buffer, int count)
+{
+	if (m_can_write == false)
+	{
+		throw new lsOperationFailedException();
+	}
+
+	DiscardReads();
+
+	if (m_write_length + count > m_buffer_size)
+	{
+		if (FlushWrites() == false)
+		{
+			throw new lsOperationFailedException();
+		}
+	}
+
+	if (count >= m_buffer_size)
+	{
+		if (lsFileHandleWrite(m_handle, buffer, count) == false)
+		{
+			throw new lsOperationFailedException();
+		}
+		m_buffer_offset += count;
+		return;
+	}
+
+	memcpy(m_buffer + m_write_length, buffer, count);
+	m_write_length += count;
+}
+
+// -------------------------------------------------------------------------
+//	Reads up to count bytes into the array from the offset given, one byte
+//	to each element. Returns how many were read.
+// -------------------------------------------------------------------------
+int lsFileStream::Read(lsArray<int>* buffer, int offset, int count)
+{
+	if (offset < 0 || count < 0 || offset + count > buffer->Length())
+	{
+		throw new lsOutOfBoundsException();
+	}
+
+	int* output = buffer->GetBuffer() + offset;
+	int  total	= 0;
+	while (total < count)
+	{
+		if (m_read_position >= m_read_length && FillBuffer() == false)
+		{
+			break;
+		}
+
+		int available = m_read_length - m_read_position;
+		int length	  = (count - total < available) ? count - total : available;
+		for (int i = 0; i < length; i++)
+		{
+			output[total + i] = (unsigned char)m_buffer[m_read_position + i];
+		}
+		m_read_position += length;
+		total += length;
+	}
+
+	return total;
+}
+
+// -------------------------------------------------------------------------
+//	Reads a single byte, or returns -1 at the end of the file.
+// -------------------------------------------------------------------------
+int lsFileStream::ReadByte()
+{
+	if (m_read_position >= m_read_length && FillBuffer() == false)
+	{
+		return -1;
+	}
+	return (unsigned char)m_buffer[m_read_position++];
+}
+
+// -------------------------------------------------------------------------
+//	Reads up to count bytes as a string. The string is shorter only at
+//	the end of the file.
+// -------------------------------------------------------------------------
+lsString lsFileStream::ReadString(int count)
+{
+	if (count <= 0)
+	{
+		return "";
+	}
+
+	lsStringBuffer* buffer = lsStringBuffer::Allocate(count);
+	int length = ReadBytes(buffer->Buffer, count);
+	buffer->Buffer[length] = '\0';
+	buffer->Length = length;
+
+	return lsString(buffer);
+}
+
+// -------------------------------------------------------------------------
+//	Writes count elements of the array from the offset given, one byte for
+//	each element.
+// -------------------------------------------------------------------------
+void lsFileStream::Write(lsArray<int>* buffer, int offset, int count)
+{
+	if (offset < 0 || count < 0 || offset + count > buffer->Length())
+	{
+		throw new lsOutOfBoundsException();
+	}
+
+	int* input = buffer->GetBuffer() + offset;
+	char block[1024];
+	while (count > 0)
+	{
+		int length = (count < (int)sizeof(block)) ? count : (int)sizeof(block);
+		for (int i = 0; i < length; i++)
+		{
+			block[i] = (char)input[i];
+		}
+		WriteBytes(block, length);
+		input += length;
+		count -= length;
+	}
+}
+
+void lsFileStream::WriteByte(int value)
+{
+	if (m_can_write == true && m_read_length == 0 && m_write_length < m_buffer_size)
+	{
+		m_buffer[m_write_length++] = (char)value;
+		return;
+	}
+
+	char chr = (char)value;
+	WriteBytes(&chr, 1);
+}
+
+void lsFileStream::WriteString(lsString value)
+{
+	WriteBytes(value.ToCString(), value.Length());
+}
+
+// -------------------------------------------------------------------------
+//	Moves the position to an offset from the beginning, current position or
+//	end of the file, returning the new position. Seeks that stay inside
+//	the bytes already read do not touch the file.
+// -------------------------------------------------------------------------
+int lsFileStream::Seek(int offset, int origin)
+{
+	if (m_handle < 0)
+	{
+		throw new lsOperationFailedException();
+	}
+
+	if (FlushWrites() == false)
+	{
+		throw new lsOperationFailedException();
+	}
+
+	long long position = 0;
+	switch (origin)
+	{
+		case LS_SEEK_ORIGIN_BEGIN:		position = offset;											break;
+		case LS_SEEK_ORIGIN_CURRENT:	position = m_buffer_offset + m_read_position + offset;		break;
+		case LS_SEEK_ORIGIN_END:		position = lsFileHandleLength(m_handle) + offset;			break;
+		default:						throw new lsOperationFailedException();
+	}
+
+	if (position < 0)
+	{
+		throw new lsOutOfBoundsException();
+	}
+
+	if (position >= m_buffer_offset &&
+		position <= m_buffer_offset + m_read_length)
+	{
+		m_read_position = (int)(position - m_buffer_offset);
+		return (int)position;
+	}
+
+	if (lsFileHandleSeek(m_handle, position, SEEK_SET) < 0)
+	{
+		throw new lsOperationFailedException();
+	}
+
+	m_buffer_offset = position;
+	m_read_length	= 0;
+	m_read_position = 0;
+
+	return (int)position;
+}
+
+int lsFileStream::GetPosition()
+{
+	return (int)(m_buffer_offset + m_read_position + m_write_length);
+}
+
+int lsFileStream::GetLength()
+{
+	if (m_handle < 0)
+	{
+		throw new lsOperationFailedException();
+	}
+
+	long long length = lsFileHandleLength(m_handle);
+	long long end	 = m_buffer_offset + m_write_length;
+
+	return (int)(end > length ? end : length);
+}
+
+// -------------------------------------------------------------------------
+//	Returns true once every byte in the file has been read.
+// -------------------------------------------------------------------------
+bool lsFileStream::AtEnd()
+{
+	if (m_read_position < m_read_length)
+	{
+		return false;
+	}
+	return (FillBuffer() == false);
+}
+
+void lsFileStream::Flush()
+{
+	if (FlushWrites() == false)
+	{
+		throw new lsOperationFailedException();
+	}
+}
+
+// -------------------------------------------------------------------------
+//	Changes how many bytes are read ahead or held before being written.
+// -------------------------------------------------------------------------
+void lsFileStream::SetBufferSize(int size)
+{
+	if (size < 1)
+	{
+		size = 1;
+	}
+
+	if (m_handle >= 0)
+	{
+		if (FlushWrites() == false)
+		{
+			throw new lsOperationFailedException();
+		}
+		DiscardReads();
+	}
+
+	if (m_buffer != NULL)
+	{
+		char* buffer = (char*)realloc(m_buffer, size);
+		if (buffer == NULL)
+		{
+			throw new lsOutOfMemoryException();
+		}
+		m_buffer = buffer;
+	}
+	m_buffer_size = size;
+}
+
+// =========================================================================
+//	lsStreamReader.
+// =========================================================================
+lsStreamReader::lsStreamReader() :
+	m_stream(NULL),
+	m_line(NULL),
+	m_line_capacity(0)
+{
+	GC_REGISTER_FINALIZER_NO_ORDER(this, &lsStreamReader::Finalize, NULL, NULL, NULL);
+}
+
+// -------------------------------------------------------------------------
+//	Frees the line buffer once the reader has been collected.
+// -------------------------------------------------------------------------
+void lsStreamReader::Finalize(void* obj, void* client_data)
+{
+	lsStreamReader* reader = static_cast<lsStreamReader*>(obj);
+	free(reader->m_line);
+}
+
+void lsStreamReader::SetStream(lsFileStream* stream)
+{
+	m_stream = stream;
+}
+
+// -------------------------------------------------------------------------
+//	Reads up to the next newline, returning the line without it or any
+//	carriage return before it. Lines that lie entirely in the streams
+//	buffer are turned straight into strings, the rest are gathered in a
+//	buffer kept for the next call. Returns an empty string at the end.
+// -------------------------------------------------------------------------
+lsString lsStreamReader::ReadLine()
+{
+	lsFileStream* stream = m_stream;
+	int length = 0;
+
+	while (true)
+	{
+		if (stream->m_read_position >= stream->m_read_length && stream->FillBuffer() == false)
+		{
+			break;
+		}
+
+		char* start = stream->m_buffer + stream->m_read_position;
+		int	  available = stream->m_read_length - stream->m_read_position;
+		char* end = (char*)memchr(start, '\n', available);
+		int	  used = (end == NULL) ? available : (int)(end - start);
+
+		if (end != NULL && length == 0)
+		{
+			stream->m_read_position += used + 1;
+			if (used > 0 && start[used - 1] == '\r')
+			{
+				used--;
+			}
+			return lsString(start, used);
+		}
+
+		if (length + used > m_line_capacity)
+		{
+			int capacity = m_line_capacity * 2;
+			if (capacity < length + used)
+			{
+				capacity = length + used;
+			}
+
+			char* line = (char*)realloc(m_line, capacity);
+			if (line == NULL)
+			{
+				throw new lsOutOfMemoryException();
+			}
+			m_line			= line;
+			m_line_capacity = capacity;
+		}
+
+		memcpy(m_line + length, start, used);
+		length += used;
+
+		if (end != NULL)
+		{
+			stream->m_read_position += used + 1;
+			break;
+		}
+		stream->m_read_position += used;
+	}
+
+	if (length > 0 && m_line[length - 1] == '\r')
+	{
+		length--;
+	}
+	return lsString(m_line, length);
+}
+
+bool lsStreamReader::AtEnd()
+{
+	return m_stream->AtEnd();
+}
+
+// =========================================================================
+//	lsBinaryReader.
+// =========================================================================
+lsBinaryReader::lsBinaryReader() :
+	m_stream(NULL)
+{
+}
+
+void lsBinaryReader::SetStream(lsFileStream* stream)
+{
+	m_stream = stream;
+}
+
+// -------------------------------------------------------------------------
+//	Reads a 4 byte little endian integer. Throws if the end of the file is
+//	reached first.
+// -------------------------------------------------------------------------
+int lsBinaryReader::ReadInt()
+{
+	unsigned char bytes[4];
+	if (m_stream->ReadBytes((char*)bytes, 4) != 4)
+	{
+		throw new lsOperationFailedException();
+	}
+
+	return (int)((unsigned int)bytes[0]		   |
+				 ((unsigned int)bytes[1] << 8)  |
+				 ((unsigned int)bytes[2] << 16) |
+				 ((unsigned int)bytes[3] << 24));
+}
+
+float lsBinaryReader::ReadFloat()
+{
+	int   bits	= ReadInt();
+	float value = 0.0f;
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+bool lsBinaryReader::AtEnd()
+{
+	return m_stream->AtEnd();
+}
+
+// =========================================================================
+//	lsBinaryWriter.
+// =========================================================================
+lsBinaryWriter::lsBinaryWriter() :
+	m_stream(NULL)
+{
+}
+
+void lsBinaryWriter::SetStream(lsFileStream* stream)
+{
+	m_stream = stream;
+}
+
+// -------------------------------------------------------------------------
+//	Writes a 4 byte little endian integer.
+// -------------------------------------------------------------------------
+void lsBinaryWriter::WriteInt(int value)
+{
+	unsigned int bits = (unsigned int)value;
+	char bytes[4];
+	bytes[0] = (char)(bits & 0xFF);
+	bytes[1] = (char)((bits >> 8) & 0xFF);
+	bytes[2] = (char)((bits >> 16) & 0xFF);
+	bytes[3] = (char)((bits >> 24) & 0xFF);
+
+	m_stream->WriteBytes(bytes, 4);
+}
+
+void lsBinaryWriter::WriteFloat(float value)
+{
+	int bits = 0;
+	memcpy(&bits, &value, sizeof(bits));
+	WriteInt(bits);
+}
+
+// =========================================================================
+//	lsMappedFile.
+// =========================================================================
+lsMappedFile::lsMappedFile() :
+	m_buffer(NULL)
+{
+	GC_REGISTER_FINALIZER_NO_ORDER(this, &lsMappedFile::Finalize, NULL, NULL, NULL);
+}
+
+// -------------------------------------------------------------------------
+//	Drops our reference to the mapping once the file has been collected,
+//	strings still using it keep it mapped.
+// -------------------------------------------------------------------------
+void lsMappedFile::Finalize(void* obj, void* client_data)
+{
+	lsMappedFile* file = static_cast<lsMappedFile*>(obj);
+	if (file->m_buffer != NULL)
+	{
+		file->m_buffer->Release();
+	}
+}
+
+// -------------------------------------------------------------------------
+//	Unmaps the file once the last string using it has been released.
+// -------------------------------------------------------------------------
+void lsMappedFile::Unmap(lsStringBuffer* buffer)
+{
+#ifdef _WIN32
+	UnmapViewOfFile(buffer->Buffer);
+#else
+	long page_size = sysconf(_SC_PAGESIZE);
+	munmap(buffer->Buffer, ((buffer->Length / page_size) + 1) * page_size);
+#endif
+}
+
+// -------------------------------------------------------------------------
+//	Maps the file at the given path, closing any file already mapped.
+//	Strings must end with a null, so at least one zero filled byte is
+//	mapped past the end of the file. Returns false if it could not be
+//	mapped, or is too large to fit in a string.
+// -------------------------------------------------------------------------
+bool lsMappedFile::Open(lsString path)
+{
+	Close();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path.ToCString(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER size;
+	if (GetFileSizeEx(file, &size) == 0 || size.QuadPart >= INT_MAX)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	int length = (int)size.QuadPart;
+
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+
+	// Views are zero filled up to the end of their last page, files that
+	// end on a page boundary leave no room for the null so are read instead.
+	if (length == 0 || (length % info.dwPageSize) == 0)
+	{
+		lsStringBuffer* buffer = lsStringBuffer::Allocate(length);
+		DWORD read = 0;
+		bool result = (length == 0 || (ReadFile(file, buffer->Buffer, length, &read, NULL) != 0 && (int)read == length));
+		CloseHandle(file);
+
+		if (result == false)
+		{
+			buffer->Release();
+			return false;
+		}
+		buffer->Buffer[length] = '\0';
+		m_buffer = buffer;
+		return true;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	CloseHandle(file);
+	if (mapping == NULL)
+	{
+		return false;
+	}
+
+	char* view = (char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(mapping);
+	if (view == NULL)
+	{
+		return false;
+	}
+#else
+	int file = open(path.ToCString(), O_RDONLY);
+	if (file < 0)
+	{
+		return false;
+	}
+
+	struct stat info;
+	if (fstat(file, &info) != 0 || info.st_size >= INT_MAX)
+	{
+		close(file);
+		return false;
+	}
+
+	int  length	   = (int)info.st_size;
+	long page_size = sysconf(_SC_PAGESIZE);
+
+	// Reserve zero filled pages with room for at least one byte past the
+	// end, then map the file over the start of them.
+	char* view = (char*)mmap(NULL, ((length / page_size) + 1) * page_size, PROT_READ, MAP_PRIVATE | MAP_ANON, -1, 0);
+	if (view == MAP_FAILED)
+	{
+		close(file);
+		return false;
+	}
+
+	if (length > 0 && mmap(view, length, PROT_READ, MAP_PRIVATE | MAP_FIXED, file, 0) == MAP_FAILED)
+	{
+		munmap(view, ((length / page_size) + 1) * page_size);
+		close(file);
+		return false;
+	}
+	close(file);
+#endif
+
+	m_buffer = new lsStringBuffer();
+	m_buffer->Buffer = view;
+	m_buffer->Length = length;
+	m_buffer->Free	 = &lsMappedFile::Unmap;
+
+	return true;
+}
+
+// -------------------------------------------------------------------------
+//	Drops our reference to the mapping, strings still using it keep it
+//	mapped until they are released.
+// -------------------------------------------------------------------------
+void lsMappedFile::Close()
+{
+	if (m_buffer != NULL)
+	{
+		m_buffer->Release();
+		m_buffer = NULL;
+	}
+}
+
+bool lsMappedFile::IsOpen()
+{
+	return (m_buffer != NULL);
+}
+
+int lsMappedFile::GetLength()
+{
+	if (m_buffer == NULL)
+	{
+		throw new lsOperationFailedException();
+	}
+	return m_buffer->Length;
+}
+
+// -------------------------------------------------------------------------
+//	Returns the contents of the file as a string that uses the mapping
+//	rather than a copy of it. Newlines are left exactly as they are in the
+//	file.
+// -------------------------------------------------------------------------
+lsString lsMappedFile::GetText()
+{
+	if (m_buffer == NULL)
+	{
+		throw new lsOperationFailedException();
+	}
+
+	m_buffer->Retain();
+	return lsString(m_buffer);
+}
+
+// -------------------------------------------------------------------------
+//	Returns part of the contents of the file. Strings must end with a 
+//	null, so only a part that runs to the end of the file can use the 
+//	mapping, other parts are copied out of it. Either way only the pages
+//	the part is in are loaded.
+// -------------------------------------------------------------------------
+lsString lsMappedFile::GetText(int offset, int length)
+{
+	if (m_buffer == NULL)
+	{
+		throw new lsOperationFailedException();
+	}
+	if (offset < 0 || length < 0 || length > m_buffer->Length - offset)
+	{
+		throw new lsOutOfBoundsException();
+	}
+
+	if (offset == 0 && length == m_buffer->Length)
+	{
+		return GetText();
+	}
+	if (length <= LS_STRING_INLINE_LENGTH || offset + length != m_buffer->Length)
+	{
+		return lsString(m_buffer->Buffer + offset, length);
+	}
+
+	lsStringBuffer* buffer = new lsStringBuffer();
+	buffer->Buffer = m_buffer->Buffer + offset;
+	buffer->Length = length;
+	buffer->Owner  = m_buffer;
+	m_buffer->Retain();
+
+	return lsString(buffer);
+}
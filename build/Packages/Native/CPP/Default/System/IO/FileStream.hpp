@@ -0,0 +1,172 @@
+// -----------------------------------------------------------------------------
+// 	filestream.hpp
+// 	Copyright (C) 2012-2013 TwinDrills, All Rights Reserved
+// -----------------------------------------------------------------------------
+//	This package contains the declarations of the classes used to read and
+//	write files a piece at a time.
+// -----------------------------------------------------------------------------
+
+#ifndef __LS_PACKAGES_NATIVE_CPP_DEFAULT_SYSTEM_IO_FILESTREAM__
+#define __LS_PACKAGES_NATIVE_CPP_DEFAULT_SYSTEM_IO_FILESTREAM__
+
+#include "Packages/Native/CPP/Default/Compiler/Support/Types.hpp"
+
+// -----------------------------------------------------------------------------
+//	Number of bytes file streams buffer unless told otherwise.
+// -----------------------------------------------------------------------------
+#define LS_FILE_STREAM_DEFAULT_BUFFER_SIZE (64 * 1024)
+
+// -----------------------------------------------------------------------------
+//	Reads and writes a file through a buffer of its own, so small reads and
+//	writes do not each call into the OS. The buffer holds either bytes read
+//	ahead of the position, or bytes written that have yet to be flushed,
+//	never both.
+// -----------------------------------------------------------------------------
+class lsFileStream : public lsObject
+{
+private:
+	int						m_handle;
+	bool					m_can_read;
+	bool					m_can_write;
+
+	char*					m_buffer;
+	int						m_buffer_size;
+
+	// Offset in the file of the first byte in the buffer.
+	long long				m_buffer_offset;
+
+	// Bytes read into the buffer, and how many of them have been used.
+	int						m_read_length;
+	int						m_read_position;
+
+	// Bytes written to the buffer that have yet to be flushed.
+	int						m_write_length;
+
+	// Hidden links to the other open streams, see AddOpen.
+	size_t					m_next_open;
+	size_t					m_prev_open;
+
+	static void Finalize(void* obj, void* client_data);
+	static void FlushOpen();
+
+	void AddOpen();
+	void RemoveOpen();
+
+	bool FlushWrites();
+	void DiscardReads();
+	bool FillBuffer();
+
+	friend class lsStreamReader;
+
+public:
+	lsFileStream();
+
+	bool Open			(lsString path, int mode);
+	void Close			();
+	bool IsOpen			();
+
+	int  ReadBytes		(char* buffer, int count);
+	void WriteBytes		(const char* buffer, int count);
+
+	int  Read			(lsArray<int>* buffer, int offset, int count);
+	int  ReadByte		();
+	lsString ReadString	(int count);
+	void Write			(lsArray<int>* buffer, int offset, int count);
+	void WriteByte		(int value);
+	void WriteString	(lsString value);
+
+	int  Seek			(int offset, int origin);
+	int  GetPosition	();
+	int  GetLength		();
+	bool AtEnd			();
+	void Flush			();
+	void SetBufferSize	(int size);
+
+};
+
+// -----------------------------------------------------------------------------
+//	Reads a file stream a line at a time. Lines are gathered in a buffer
+//	that is kept between calls, so only the returned string is allocated.
+// -----------------------------------------------------------------------------
+class lsStreamReader : public lsObject
+{
+private:
+	lsFileStream*			m_stream;
+
+	char*					m_line;
+	int						m_line_capacity;
+
+	static void Finalize(void* obj, void* client_data);
+
+public:
+	lsStreamReader();
+
+	void SetStream		(lsFileStream* stream);
+	lsString ReadLine	();
+	bool AtEnd			();
+
+};
+
+// -----------------------------------------------------------------------------
+//	Reads integers and floats from a file stream, stored as 4 little endian
+//	bytes.
+// -----------------------------------------------------------------------------
+class lsBinaryReader : public lsObject
+{
+private:
+	lsFileStream*			m_stream;
+
+public:
+	lsBinaryReader();
+
+	void  SetStream		(lsFileStream* stream);
+	int   ReadInt		();
+	float ReadFloat		();
+	bool  AtEnd			();
+
+};
+
+// -----------------------------------------------------------------------------
+//	Writes integers and floats to a file stream as 4 little endian bytes.
+// -----------------------------------------------------------------------------
+class lsBinaryWriter : public lsObject
+{
+private:
+	lsFileStream*			m_stream;
+
+public:
+	lsBinaryWriter();
+
+	void SetStream		(lsFileStream* stream);
+	void WriteInt		(int value);
+	void WriteFloat		(float value);
+
+};
+
+// -----------------------------------------------------------------------------
+//	Maps a file into memory read only, so its contents can be used as a
+//	string without being read or copied. Pages are loaded by the OS as they
+//	are first touched.
+// -----------------------------------------------------------------------------
+class lsMappedFile : public lsObject
+{
+private:
+	lsStringBuffer*			m_buffer;
+
+	static void Finalize(void* obj, void* client_data);
+	static void Unmap(lsStringBuffer* buffer);
+
+public:
+	lsMappedFile();
+
+	bool Open			(lsString path);
+	void Close			();
+	bool IsOpen			();
+	int  GetLength		();
+	lsString GetText	();
+	lsString GetText	(int offset, int length);
+
+};
+
+#endif // __LS_PACKAGES_NATIVE_CPP_DEFAULT_SYSTEM_IO_FILESTREAM__
+
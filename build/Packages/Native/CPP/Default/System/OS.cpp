@@ -41,7 +41,11 @@ int lsOS::GetTicks()
 #ifdef _WIN32
 	return GetTickCount();
 #else defined(__linux__) 
-	return clock() / (CLOCKS_PER_SEC / 1000);
+	// clock() measures processor time used by every thread of the process
+	// rather than time that has passed, so use the monotonic clock.
+	timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return (int)(time.tv_sec * 1000 + time.tv_nsec / 1000000);
 #endif
 }
 
@@ -58,6 +62,10 @@ void lsOS::Exit(int exitcode)
 // -------------------------------------------------------------------------
 bool lsOS::Execute(lsString path, lsString cmd_line)
 {
+	// Write out buffered output first so it comes before the programs, and
+	// isn't copied into it by fork.
+	fflush(NULL);
+
 #ifdef _WIN32
 	PROCESS_INFORMATION pi = { 0 };
 	STARTUPINFOA		si = { sizeof(si) };
@@ -90,7 +98,7 @@ bool lsOS::Execute(lsString path, lsString cmd_line)
 	
 	case 0: 
 		execl(path.ToCString(), path.ToCString(), cmd_line.ToCString(), NULL); 
-		exit(1);
+		_exit(1);
 		
 	default: 
 		while (!WIFEXITED(status)) 
@@ -0,0 +1,394 @@
+// -----------------------------------------------------------------------------
+// 	thread.cpp
+// 	Copyright (C) 2012-2013 TwinDrills, All Rights Reserved
+// -----------------------------------------------------------------------------
+//	This package contains the code used to run code on multiple threads
+//	at once.
+// -----------------------------------------------------------------------------
+
+#ifdef _WIN32
+
+#include <Windows.h>
+#include <process.h>
+
+#define LS_THREAD_LOCAL __declspec(thread)
+
+#else defined(__linux__) || defined(__APPLE__)
+
+#include <pthread.h>
+#include <unistd.h>
+#include <time.h>
+
+#define LS_THREAD_LOCAL __thread
+
+#endif
+
+#include "Packages/Native/CPP/Default/System/Threading/Thread.hpp"
+
+// Threads have to be created through the collector so it can find the
+// objects their stacks reference.
+#define GC_THREADS
+#include "Packages/Native/CPP/Default/System/GC/include/gc.h"
+
+// Thread local slot values of the thread currently running. Threads that
+// were not started by us, such as the main thread, share g_main_locals.
+// Both are only ever set to arrays also referenced from the thread object
+// or static data, as the collector does not look at thread local storage.
+static LS_THREAD_LOCAL lsThread*	g_current_thread	= NULL;
+static lsArray<lsObject*>*			g_main_locals		= NULL;
+static volatile int					g_next_local_slot	= 0;
+
+// =========================================================================
+//	lsThread.
+// =========================================================================
+lsThread::lsThread() :
+	m_started(false),
+	m_joined(false),
+	m_running(0),
+	m_locals(NULL)
+{
+}
+
+// -------------------------------------------------------------------------
+//	Invoked on the new thread once it is started. Derived classes override
+//	this with the work the thread should do.
+// -------------------------------------------------------------------------
+void lsThread::Run()
+{
+}
+
+// -------------------------------------------------------------------------
+//	Entry point of all threads. Runs the thread object it is given.
+// -------------------------------------------------------------------------
+#ifdef _WIN32
+unsigned int __stdcall lsThread::Entry(void* thread)
+#else
+void* lsThread::Entry(void* thread)
+#endif
+{
+	lsThread* self = static_cast<lsThread*>(thread);
+	g_current_thread = self;
+
+	self->Run();
+
+	lsAtomicExchange(&self->m_running, 0);
+	g_current_thread = NULL;
+
+	return 0;
+}
+
+// -------------------------------------------------------------------------
+//	Starts running the thread. A thread can only be started once.
+// -------------------------------------------------------------------------
+void lsThread::Start()
+{
+	if (m_started == true)
+	{
+		throw new lsOperationFailedException();
+	}
+
+	// From now on reference counts have to be updated atomically.
+	lsMultiThreaded = true;
+
+	m_started = true;
+	m_running = 1;
+
+#ifdef _WIN32
+	m_handle = (HANDLE)GC_beginthreadex(NULL, 0, &lsThread::Entry, this, 0, NULL);
+	if (m_handle == 0)
+#else
+	if (GC_pthread_create(&m_handle, NULL, &lsThread::Entry, this) != 0)
+#endif
+	{
+		m_started = false;
+		m_running = 0;
+		throw new lsOperationFailedException();
+	}
+}
+
+// -------------------------------------------------------------------------
+//	Waits for the thread to finish running.
+// -------------------------------------------------------------------------
+void lsThread::Join()
+{
+	if (m_started == false || m_joined == true)
+	{
+		return;
+	}
+
+#ifdef _WIN32
+	WaitForSingleObject(m_handle, INFINITE);
+	CloseHandle(m_handle);
+#else
+	GC_pthread_join(m_handle, NULL);
+#endif
+
+	m_joined = true;
+}
+
+// -------------------------------------------------------------------------
+//	Returns true if the thread has been started and not yet finished.
+// -------------------------------------------------------------------------
+bool lsThread::IsRunning()
+{
+	return lsAtomicAdd(&m_running, 0) != 0;
+}
+
+// -------------------------------------------------------------------------
+//	Suspends the calling thread for the given number of milliseconds.
+// -------------------------------------------------------------------------
+void lsThread::Sleep(int milliseconds)
+{
+#ifdef _WIN32
+	::Sleep(milliseconds);
+#else
+	timespec time;
+	time.tv_sec  = milliseconds / 1000;
+	time.tv_nsec = (milliseconds % 1000) * 1000000L;
+	nanosleep(&time, NULL);
+#endif
+}
+
+// -------------------------------------------------------------------------
+//	Gets the number of processors threads can run on at once.
+// -------------------------------------------------------------------------
+int lsThread::GetProcessorCount()
+{
+#ifdef _WIN32
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return info.dwNumberOfProcessors;
+#else
+	int count = sysconf(_SC_NPROCESSORS_ONLN);
+	return count < 1 ? 1 : count;
+#endif
+}
+
+// -------------------------------------------------------------------------
+//	Gets the slot values of the calling thread.
+// -------------------------------------------------------------------------
+lsArray<lsObject*>** lsThread::GetLocals()
+{
+	return g_current_thread == NULL ? &g_main_locals : &g_current_thread->m_locals;
+}
+
+// -------------------------------------------------------------------------
+//	Reserves a slot that every thread can store its own value in.
+// -------------------------------------------------------------------------
+int lsThread::AllocateLocalSlot()
+{
+	return lsAtomicAdd(&g_next_local_slot, 1);
+}
+
+// -------------------------------------------------------------------------
+//	Gets the value the calling thread has stored in a slot, or NULL if it
+//	has not stored one.
+// -------------------------------------------------------------------------
+lsObject* lsThread::GetLocal(int slot)
+{
+	lsArray<lsObject*>* locals = *GetLocals();
+	if (locals == NULL || slot >= locals->Length())
+	{
+		return NULL;
+	}
+	return locals->GetBuffer()[slot];
+}
+
+// -------------------------------------------------------------------------
+//	Stores a value in a slot for the calling thread.
+// -------------------------------------------------------------------------
+void lsThread::SetLocal(int slot, lsObject* value)
+{
+	lsArray<lsObject*>** locals = GetLocals();
+	if (*locals == NULL)
+	{
+		*locals = new lsArray<lsObject*>(slot + 1);
+	}
+	else if (slot >= (*locals)->Length())
+	{
+		(*locals)->Resize(slot + 1);
+	}
+	(*locals)->GetBuffer()[slot] = value;
+}
+
+// =========================================================================
+//	lsMutex.
+// =========================================================================
+lsMutex::lsMutex()
+{
+#ifdef _WIN32
+	InitializeCriticalSection(&m_handle);
+#else
+	pthread_mutex_init(&m_handle, NULL);
+#endif
+	GC_REGISTER_FINALIZER_NO_ORDER(this, &lsMutex::Finalize, NULL, NULL, NULL);
+}
+
+// -------------------------------------------------------------------------
+//	Releases the mutex once it has been collected.
+// -------------------------------------------------------------------------
+void lsMutex::Finalize(void* obj, void* client_data)
+{
+	lsMutex* mutex = static_cast<lsMutex*>(obj);
+#ifdef _WIN32
+	DeleteCriticalSection(&mutex->m_handle);
+#else
+	pthread_mutex_destroy(&mutex->m_handle);
+#endif
+}
+
+// -------------------------------------------------------------------------
+//	Waits until no other thread holds the mutex, then takes it.
+// -------------------------------------------------------------------------
+void lsMutex::Lock()
+{
+#ifdef _WIN32
+	EnterCriticalSection(&m_handle);
+#else
+	pthread_mutex_lock(&m_handle);
+#endif
+}
+
+// -------------------------------------------------------------------------
+//	Takes the mutex if no other thread holds it. Returns true if taken.
+// -------------------------------------------------------------------------
+bool lsMutex::TryLock()
+{
+#ifdef _WIN32
+	return TryEnterCriticalSection(&m_handle) != 0;
+#else
+	return pthread_mutex_trylock(&m_handle) == 0;
+#endif
+}
+
+// -------------------------------------------------------------------------
+//	Releases the mutex so other threads can take it.
+// -------------------------------------------------------------------------
+void lsMutex::Unlock()
+{
+#ifdef _WIN32
+	LeaveCriticalSection(&m_handle);
+#else
+	pthread_mutex_unlock(&m_handle);
+#endif
+}
+
+// =========================================================================
+//	lsConditionVariable.
+// =========================================================================
+lsConditionVariable::lsConditionVariable()
+{
+#ifdef _WIN32
+	InitializeConditionVariable(&m_handle);
+#else
+	pthread_cond_init(&m_handle, NULL);
+	GC_REGISTER_FINALIZER_NO_ORDER(this, &lsConditionVariable::Finalize, NULL, NULL, NULL);
+#endif
+}
+
+// -------------------------------------------------------------------------
+//	Releases the condition variable once it has been collected.
+// -------------------------------------------------------------------------
+void lsConditionVariable::Finalize(void* obj, void* client_data)
+{
+#ifndef _WIN32
+	pthread_cond_destroy(&static_cast<lsConditionVariable*>(obj)->m_handle);
+#endif
+}
+
+// -------------------------------------------------------------------------
+//	Releases the mutex, which must be held, and sleeps until woken by
+//	another thread. The mutex is held again once this returns. Threads can
+//	occasionally wake without being signalled so the condition being
+//	waited for should always be checked again.
+// -------------------------------------------------------------------------
+void lsConditionVariable::Wait(lsMutex* mutex)
+{
+#ifdef _WIN32
+	SleepConditionVariableCS(&m_handle, &mutex->m_handle, INFINITE);
+#else
+	pthread_cond_wait(&m_handle, &mutex->m_handle);
+#endif
+}
+
+// -------------------------------------------------------------------------
+//	Wakes one thread waiting on the condition variable.
+// -------------------------------------------------------------------------
+void lsConditionVariable::Signal()
+{
+#ifdef _WIN32
+	WakeConditionVariable(&m_handle);
+#else
+	pthread_cond_signal(&m_handle);
+#endif
+}
+
+// -------------------------------------------------------------------------
+//	Wakes every thread waiting on the condition variable.
+// -------------------------------------------------------------------------
+void lsConditionVariable::Broadcast()
+{
+#ifdef _WIN32
+	WakeAllConditionVariable(&m_handle);
+#else
+	pthread_cond_broadcast(&m_handle);
+#endif
+}
+
+// =========================================================================
+//	lsInterlocked.
+// =========================================================================
+
+// -------------------------------------------------------------------------
+//	Gets the address of an array element, checking it is in bounds.
+// -------------------------------------------------------------------------
+static volatile int* lsInterlockedElement(lsArray<int>* values, int index)
+{
+	if (index < 0 || index >= values->Length())
+	{
+		throw new lsOutOfBoundsException();
+	}
+	return values->GetBuffer() + index;
+}
+
+// -------------------------------------------------------------------------
+//	Reads an element, seeing any value written by another thread.
+// -------------------------------------------------------------------------
+int lsInterlocked::Get(lsArray<int>* values, int index)
+{
+	return lsAtomicAdd(lsInterlockedElement(values, index), 0);
+}
+
+// -------------------------------------------------------------------------
+//	Writes an element so other threads see the value.
+// -------------------------------------------------------------------------
+void lsInterlocked::Set(lsArray<int>* values, int index, int value)
+{
+	lsAtomicExchange(lsInterlockedElement(values, index), value);
+}
+
+// -------------------------------------------------------------------------
+//	Adds to an element and returns its new value.
+// -------------------------------------------------------------------------
+int lsInterlocked::Add(lsArray<int>* values, int index, int amount)
+{
+	return lsAtomicAdd(lsInterlockedElement(values, index), amount) + amount;
+}
+
+// -------------------------------------------------------------------------
+//	Replaces an element and returns its old value.
+// -------------------------------------------------------------------------
+int lsInterlocked::Exchange(lsArray<int>* values, int index, int value)
+{
+	return lsAtomicExchange(lsInterlockedElement(values, index), value);
+}
+
+// -------------------------------------------------------------------------
+//	Replaces an element if it holds the expected value. Returns the value
+//	it held before, which is the expected value if it was replaced.
+// -------------------------------------------------------------------------
+int lsInterlocked::CompareExchange(lsArray<int>* values, int index, int expected, int value)
+{
+	return lsAtomicCompareExchange(lsInterlockedElement(values, index), expected, value);
+}
+
@@ -0,0 +1,130 @@
+// -----------------------------------------------------------------------------
+// 	thread.hpp
+// 	Copyright (C) 2012-2013 TwinDrills, All Rights Reserved
+// -----------------------------------------------------------------------------
+//	This package contains the declarations of the classes used to run code
+//	on multiple threads at once.
+// -----------------------------------------------------------------------------
+
+#ifndef __LS_PACKAGES_NATIVE_CPP_DEFAULT_SYSTEM_THREADING_THREAD__
+#define __LS_PACKAGES_NATIVE_CPP_DEFAULT_SYSTEM_THREADING_THREAD__
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <pthread.h>
+#endif
+
+#include "Packages/Native/CPP/Default/Compiler/Support/Types.hpp"
+
+// -----------------------------------------------------------------------------
+//	Runs its Run method on a thread of its own once started. Threads are
+//	registered with the garbage collector so objects they reference are
+//	never collected from underneath them.
+// -----------------------------------------------------------------------------
+class lsThread : public lsObject
+{
+private:
+#ifdef _WIN32
+	HANDLE					m_handle;
+#else
+	pthread_t				m_handle;
+#endif
+	bool					m_started;
+	bool					m_joined;
+	volatile int			m_running;
+
+	// Values of thread local slots for this thread.
+	lsArray<lsObject*>*		m_locals;
+
+#ifdef _WIN32
+	static unsigned int __stdcall Entry(void* thread);
+#else
+	static void* Entry(void* thread);
+#endif
+
+	static lsArray<lsObject*>** GetLocals();
+
+public:
+	lsThread();
+
+	virtual void Run();
+
+	void Start();
+	void Join();
+	bool IsRunning();
+
+	static void Sleep(int milliseconds);
+	static int  GetProcessorCount();
+
+	static int		 AllocateLocalSlot();
+	static lsObject* GetLocal(int slot);
+	static void		 SetLocal(int slot, lsObject* value);
+
+};
+
+// -----------------------------------------------------------------------------
+//	Allows only one thread at a time to hold it.
+// -----------------------------------------------------------------------------
+class lsMutex : public lsObject
+{
+private:
+#ifdef _WIN32
+	CRITICAL_SECTION		m_handle;
+#else
+	pthread_mutex_t			m_handle;
+#endif
+
+	static void Finalize(void* obj, void* client_data);
+
+	friend class lsConditionVariable;
+
+public:
+	lsMutex();
+
+	void Lock();
+	bool TryLock();
+	void Unlock();
+
+};
+
+// -----------------------------------------------------------------------------
+//	Lets threads sleep until another thread signals that something they
+//	are waiting for has happened.
+// -----------------------------------------------------------------------------
+class lsConditionVariable : public lsObject
+{
+private:
+#ifdef _WIN32
+	CONDITION_VARIABLE		m_handle;
+#else
+	pthread_cond_t			m_handle;
+#endif
+
+	static void Finalize(void* obj, void* client_data);
+
+public:
+	lsConditionVariable();
+
+	void Wait(lsMutex* mutex);
+	void Signal();
+	void Broadcast();
+
+};
+
+// -----------------------------------------------------------------------------
+//	Atomic operations on the elements of integer arrays.
+// -----------------------------------------------------------------------------
+class lsInterlocked
+{
+public:
+	static int Get				(lsArray<int>* values, int index);
+	static void Set				(lsArray<int>* values, int index, int value);
+	static int Add				(lsArray<int>* values, int index, int amount);
+	static int Exchange			(lsArray<int>* values, int index, int value);
+	static int CompareExchange	(lsArray<int>* values, int index, int expected, int value);
+
+};
+
+#endif // __LS_PACKAGES_NATIVE_CPP_DEFAULT_SYSTEM_THREADING_THREAD__
+
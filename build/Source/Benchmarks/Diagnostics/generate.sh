@@ -0,0 +1,39 @@
+#!/bin/sh
+# -----------------------------------------------------------------------------
+# 	generate.sh
+# 	Copyright (C) 2012-2013 TwinDrills, All Rights Reserved
+# -----------------------------------------------------------------------------
+#	Writes Generated.ls, with the given number of constants (20000 by default)
+#	that are each needlessly declared static. Every one of them is reported as
+#	a warning, quoting its source line. The constants are split over classes
+#	of 100, so the time is not dominated by member lookups within a class.
+#
+#	Compile it with "../compile_with_bootstrapper.sh Diagnostics Debug -profile",
+#	the parse phase includes the time spent reporting the warnings.
+# -----------------------------------------------------------------------------
+
+COUNT=${1:-20000}
+cd "$(dirname "$0")"
+
+{
+	echo "using System.*;"
+	echo ""
+	i=0
+	while [ $i -lt $COUNT ]; do
+		if [ $((i % 100)) -eq 0 ]; then
+			[ $i -gt 0 ] && echo "}"
+			echo "public class Constants$((i / 100))"
+			echo "{"
+		fi
+		echo "	public static const int C$i = $i;"
+		i=$((i + 1))
+	done
+	[ $i -gt 0 ] && echo "}"
+	echo "public class App"
+	echo "{"
+	echo "	public static int Main(string[] args)"
+	echo "	{"
+	echo "		return 0;"
+	echo "	}"
+	echo "}"
+} > Generated.ls
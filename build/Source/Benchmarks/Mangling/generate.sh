@@ -0,0 +1,46 @@
+#!/bin/sh
+# -----------------------------------------------------------------------------
+# 	generate.sh
+# 	Copyright (C) 2012-2013 TwinDrills, All Rights Reserved
+# -----------------------------------------------------------------------------
+#	Writes Generated.ls, with the given number of classes (100 by default) 
+#	that each have the given number of fields and methods (50 of each by
+#	default). Every method declares a local called i, so every one of them
+#	has to be mangled to a different name.
+#
+#	Compile it with "../compile_with_bootstrapper.sh Mangling Debug -profile",
+#	the mangling is done during the semant phase.
+# -----------------------------------------------------------------------------
+
+CLASSES=${1:-100}
+MEMBERS=${2:-50}
+cd "$(dirname "$0")"
+
+{
+	echo "using System.*;"
+	echo ""
+	c=0
+	while [ $c -lt $CLASSES ]; do
+		echo "public class Members$c"
+		echo "{"
+		m=0
+		while [ $m -lt $MEMBERS ]; do
+			echo "	public int f$m;"
+			echo "	public int m$m()"
+			echo "	{"
+			echo "		int i = $m;"
+			echo "		return i + f$m;"
+			echo "	}"
+			m=$((m + 1))
+		done
+		echo "}"
+		c=$((c + 1))
+	done
+	echo "public class App"
+	echo "{"
+	echo "	public static int Main(string[] args)"
+	echo "	{"
+	echo "		return 0;"
+	echo "	}"
+	echo "}"
+} > Generated.ls
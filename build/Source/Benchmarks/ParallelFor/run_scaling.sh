@@ -0,0 +1,23 @@
+#!/bin/sh
+# -----------------------------------------------------------------------------
+# 	run_scaling.sh
+# 	Copyright (C) 2012-2013 TwinDrills, All Rights Reserved
+# -----------------------------------------------------------------------------
+#	Runs the ParallelFor benchmark once for every thread count from 1 up to
+#	the number of processors, or the count given, eg.
+#
+#		./run_scaling.sh 8
+#
+#	The task pool can only be started once, so each thread count is a
+#	separate run. Compile the benchmark with compile_with_bootstrapper.sh
+#	first.
+# -----------------------------------------------------------------------------
+
+THREADS=${1:-$(nproc)}
+BENCHMARK="$(dirname "$0")/../../../Bin/Benchmarks/ParallelFor.linux"
+
+i=1
+while [ $i -le $THREADS ]; do
+	"$BENCHMARK" $((i - 1)) || exit 1
+	i=$((i + 1))
+done
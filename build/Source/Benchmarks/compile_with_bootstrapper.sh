@@ -0,0 +1,31 @@
+#!/bin/sh
+# -----------------------------------------------------------------------------
+# 	compile_with_bootstrapper.sh
+# 	Copyright (C) 2012-2013 TwinDrills, All Rights Reserved
+# -----------------------------------------------------------------------------
+#	Compiles one of the benchmarks with the bootstrapper, eg.
+#
+#		./compile_with_bootstrapper.sh Arrays Release
+#
+#	Release builds are compiled with -O2. Any further arguments are passed on
+#	to the bootstrapper, so -profile can be given to time the compile itself.
+#	The benchmark is written to Bin/Benchmarks.
+# -----------------------------------------------------------------------------
+
+NAME=$1
+CONFIG=${2:-Release}
+shift 2 2>/dev/null || shift $#
+
+if [ -z "$NAME" ]; then
+	echo "Usage: $0 <benchmark> [Debug|Release] [bootstrapper options]"
+	exit 1
+fi
+
+if [ "$CONFIG" = "Release" ]; then
+	MAKE_CFLAGS="${MAKE_CFLAGS:--O2}"
+	export MAKE_CFLAGS
+fi
+
+cd "$(dirname "$0")/../../"
+mkdir -p Bin/Benchmarks
+Bin/Bootstrapper.linux -action compile -source "Source/Benchmarks/$NAME/$NAME.lsproject" -config "$CONFIG" -platform "Linux" "$@"